@@ -6,16 +6,60 @@ extern po::variables_map vm;
 
 void AddBench()
 {
+    if (!IsProjectRoot())
+    {
+        LOGERR("must be under the project root directory!");
+    }
+    WriterContext ctx;
+    if (!LoadWriterContext(".", ctx))
+    {
+        LOGERR("no project() found in CMakeLists.txt, the repo is not created by cmaker");
+    }
+    std::ifstream cmakelist("CMakeLists.txt");
+    std::string text((std::istreambuf_iterator<char>(cmakelist)), std::istreambuf_iterator<char>());
+
+    GeneratedHashes generated;
+    ctx.generated = &generated;
     CreateDirIfNotExist("bench");
-    WriteBenchmark();
+    WriteBenchmark(ctx);
     LOGINFO("Benchmark template generated!");
-    LOGINFO("Remember to add the following lines into your CMakeLists.txt to take effect:");
-    fmt::print(R"(
-option(BUILD_BENCHMARKS "build benchmark tests" OFF)
-if(BUILD_BENCHMARKS)
-    find_package(benchmark REQUIRED)
-    add_subdirectory(bench)
-endif()
 
-)");
-}
\ No newline at end of file
+    // the new benchmarks join the source lists
+    RegenSummary summary;
+    ctx.regen = &summary;
+    ctx.verbose = false;
+    WriteSources(ctx);
+    SaveGeneratedHashes(ctx);
+    if (text.find("add_subdirectory(bench)") == std::string::npos)
+    {
+        LOGWARN("CMakeLists.txt doesn't add bench/ yet, run 'cmaker regen' to update it");
+    }
+    LOGINFO("Build them with: cmake -B build -DBUILD_BENCHMARKS=ON");
+}
+
+void AddMachineBench()
+{
+    if (!IsProjectRoot())
+    {
+        LOGERR("must be under the project root directory!");
+    }
+    std::ifstream bench_cmakelist("bench/CMakeLists.txt");
+    if (!bench_cmakelist)
+    {
+        LOGERR("bench/CMakeLists.txt is missing, run 'cmaker template bench' first");
+    }
+    std::string text(
+        (std::istreambuf_iterator<char>(bench_cmakelist)), std::istreambuf_iterator<char>());
+    CreateDirIfNotExist("bench/machine");
+    WriterContext ctx;
+    GeneratedHashes generated;
+    ctx.generated = &generated;
+    WriteMachineBench(ctx);
+    SaveGeneratedHashes(ctx);
+    LOGINFO("Machine calibration template generated!");
+    if (text.find("add_subdirectory(machine)") == std::string::npos)
+    {
+        LOGWARN("bench/CMakeLists.txt doesn't add bench/machine yet, run 'cmaker regen' to update it");
+    }
+    LOGINFO("Run it with: cmake --build <build dir> --target machine-bench");
+}
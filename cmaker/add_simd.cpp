@@ -0,0 +1,37 @@
+#include "functions.h"
+#include "writer_funcs.h"
+
+extern po::variables_map vm;
+
+void AddSimd()
+{
+    if (!IsProjectRoot())
+    {
+        LOGERR("must be under the project root directory!");
+    }
+    WriterContext ctx;
+    if (!LoadWriterContext(".", ctx))
+    {
+        LOGERR("no project() found in CMakeLists.txt, the repo is not created by cmaker");
+    }
+    std::ifstream cmakelist("CMakeLists.txt");
+    std::string text((std::istreambuf_iterator<char>(cmakelist)), std::istreambuf_iterator<char>());
+
+    GeneratedHashes generated;
+    ctx.generated = &generated;
+    CreateDirIfNotExist("simd");
+    WriteSimdKernels(ctx);
+    LOGINFO("SIMD kernels template generated!");
+
+    // the unit test and the benchmark of the kernels join the source lists
+    RegenSummary summary;
+    ctx.regen = &summary;
+    ctx.verbose = false;
+    WriteSources(ctx);
+    SaveGeneratedHashes(ctx);
+    if (text.find("add_subdirectory(simd)") == std::string::npos)
+    {
+        LOGWARN("CMakeLists.txt doesn't add simd/ yet, run 'cmaker regen' to update it");
+    }
+    LOGINFO("Check every ISA level with: ctest -R SIMD, compare them with: bench_simd");
+}
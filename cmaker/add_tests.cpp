@@ -10,19 +10,31 @@ void AddTests()
     {
         LOGERR("must be under the project root directory!");
     }
+    WriterContext ctx;
+    if (!LoadWriterContext(".", ctx))
+    {
+        LOGERR("no project() found in CMakeLists.txt, the repo is not created by cmaker");
+    }
+    std::ifstream cmakelist("CMakeLists.txt");
+    std::string text((std::istreambuf_iterator<char>(cmakelist)), std::istreambuf_iterator<char>());
+
+    GeneratedHashes generated;
+    ctx.generated = &generated;
     CreateDirIfNotExist("unit_test");
-    WriteUnitTests();
+    WriteUnitTests(ctx);
     LOGINFO("Unittests template generated!");
-    LOGINFO("Remember to add the following lines into your CMakeLists.txt to take effect:");
-    fmt::print(R"(
-option(BUILD_TESTS "build unit tests" OFF)
-if(BUILD_TESTS)
-    find_package(GTest REQUIRED)
-    enable_testing()
-    add_subdirectory(unit_test)
-endif()
 
-)");
+    // the new unit tests join the source lists
+    RegenSummary summary;
+    ctx.regen = &summary;
+    ctx.verbose = false;
+    WriteSources(ctx);
+    SaveGeneratedHashes(ctx);
+    if (text.find("add_subdirectory(unit_test)") == std::string::npos)
+    {
+        LOGWARN("CMakeLists.txt doesn't add unit_test/ yet, run 'cmaker regen' to update it");
+    }
+    LOGINFO("Build them with: cmake -B build -DBUILD_TESTS=ON");
 }
 
 void AddTemplate()
@@ -35,20 +47,28 @@ void AddTemplate()
     if (vm.count("name") == 0)
     {
         LOGERR("Missing operend for 'template' operation. Available templates:");
-        fmt::print("    [bench, tests]\n");
+        fmt::print("    [bench, machine-bench, simd, tests]\n");
         return;
     }
     auto name = vm["name"].as<std::string>();
     if (name == "help")
     {
         LOGINFO("Available templates:");
-        fmt::print("    [bench, tests]\n");
+        fmt::print("    [bench, machine-bench, simd, tests]\n");
         return;
     }
     if (name == "bench")
     {
         AddBench();
     }
+    else if (name == "machine-bench")
+    {
+        AddMachineBench();
+    }
+    else if (name == "simd")
+    {
+        AddSimd();
+    }
     else if (name == "tests")
     {
         AddTests();
@@ -0,0 +1,121 @@
+#include "bench_results.h"
+#include <cmath>
+
+extern po::variables_map vm;
+
+static BenchResults LoadOrDie(std::string const &path)
+{
+    BenchResults results;
+    std::string error;
+    if (!LoadBenchResults(path, results, error))
+    {
+        LOGERR("failed to load benchmark results from {}: {}", path, error);
+    }
+    return results;
+}
+
+void BenchDiff()
+{
+    if (vm.count("name") == 0 || vm.count("operand") == 0)
+    {
+        LOGERR("usage: cmaker bench-diff base.json new.json, both written by a benchmark run with "
+               "--benchmark_out=<file> --benchmark_repetitions=<n>");
+    }
+    auto base_path = vm["name"].as<std::string>();
+    auto new_path = vm["operand"].as<std::string>();
+    auto base = LoadOrDie(base_path);
+    auto head = LoadOrDie(new_path);
+
+    auto metric = vm["metric"].as<std::string>();
+    CheckOptionChoice("metric", metric, {"real_time", "cpu_time"});
+    double threshold = vm["threshold"].as<double>();
+    double alpha = vm["alpha"].as<double>();
+    if (alpha <= 0 || alpha >= 1)
+    {
+        LOGERR("invalid value '{}' for --alpha, expects a probability between 0 and 1", alpha);
+    }
+    auto samples = [&metric](BenchRun const &run) -> std::vector<double> const & {
+        return metric == "cpu_time" ? run.cpu_time : run.real_time;
+    };
+
+    size_t width = 9;
+    for (auto const &run : base.runs)
+    {
+        width = std::max(width, run.name.size());
+    }
+    LOGINFO("{} of {} against {}, {:.0f}% confidence, regression threshold {:.1f}%", metric,
+        new_path, base_path, (1 - alpha) * 100, threshold);
+    fmt::print("{:<{}}  {:>12}  {:>12}  {:>9}  {:>19}  {:>7}\n", "benchmark", width, "base",
+        "new", "delta", "confidence interval", "p-value");
+
+    size_t regressions = 0, improvements = 0;
+    bool too_few_samples = false;
+    for (auto const &base_run : base.runs)
+    {
+        auto const *new_run = head.Find(base_run.name);
+        if (!new_run)
+        {
+            fmt::print("{:<{}}  " YELLOW("removed") "\n", base_run.name, width);
+            continue;
+        }
+        auto const &a = samples(base_run);
+        auto const &b = samples(*new_run);
+        double base_median = Median(a), new_median = Median(b);
+        if (base_median <= 0)
+        {
+            continue;
+        }
+        double delta = (new_median / base_median - 1) * 100;
+
+        // too few samples can't tell noise from change at alpha, such as 3 and 3 at 0.05, fall
+        // back to the threshold
+        bool testable = MannWhitneyMinPValue(a.size(), b.size()) < alpha;
+        too_few_samples = too_few_samples || !testable;
+        double p_value = testable ? MannWhitneyU(a, b) : 0;
+        auto shift = HodgesLehmann(a, b, 1 - alpha);
+        bool significant = !testable || p_value < alpha;
+
+        std::string delta_cell = fmt::format("{:>+8.2f}%", delta);
+        std::string verdict;
+        if (significant && delta > threshold)
+        {
+            delta_cell = fmt::format(RED("{}"), delta_cell);
+            verdict = "  " RED("regression");
+            ++regressions;
+        }
+        else if (significant && delta < -threshold)
+        {
+            delta_cell = fmt::format(GREEN("{}"), delta_cell);
+            verdict = "  " GREEN("improvement");
+            ++improvements;
+        }
+        fmt::print("{:<{}}  {:>12}  {:>12}  {}  {:>19}  {:>7}{}\n", base_run.name, width,
+            FormatTime(base_median), FormatTime(new_median), delta_cell,
+            testable ? fmt::format("[{:+.2f}%, {:+.2f}%]", shift.low / base_median * 100,
+                           shift.high / base_median * 100)
+                     : "n/a",
+            testable ? fmt::format("{:.4f}", p_value) : "n/a", verdict);
+    }
+    for (auto const &new_run : head.runs)
+    {
+        if (!base.Find(new_run.name))
+        {
+            fmt::print("{:<{}}  " SKY("added") "\n", new_run.name, width);
+        }
+    }
+
+    if (too_few_samples)
+    {
+        LOGWARN("some benchmarks have too few samples to test the deltas against the noise at "
+                "{:.0f}% confidence, only the threshold is checked, run them with "
+                "--benchmark_repetitions=10 or more",
+            (1 - alpha) * 100);
+    }
+    if (regressions > 0)
+    {
+        LOGWARN(RED("{} regression(s)") ", {} improvement(s) beyond {:.1f}%", regressions,
+            improvements, threshold);
+        exit(2);
+    }
+    LOGINFO(GREEN("no regression") ", {} improvement(s) beyond {:.1f}%", improvements, threshold);
+}
@@ -0,0 +1,295 @@
+#include "bench_results.h"
+#include "template.h"
+
+extern po::variables_map vm;
+
+// one run of a benchmark in the history
+struct HistoryPoint
+{
+    std::string timestamp;
+    std::string git_sha;
+    double time;
+};
+
+// the history of the benchmarks of one benchmark executable, in the order of the runs
+struct BenchHistory
+{
+    std::string executable;
+    size_t run_count{0};
+    // benchmark names in the order they first appear
+    std::vector<std::string> names;
+    std::map<std::string, std::vector<HistoryPoint>> series;
+};
+
+// the run-benchmarks target files every result as <dir>/<executable>/<timestamp>_<sha>.json
+static std::vector<BenchHistory> LoadHistory(fs::path const &dir, std::string const &metric)
+{
+    std::vector<fs::path> executables;
+    for (fs::directory_iterator it(dir), end; it != end; ++it)
+    {
+        if (fs::is_directory(it->path()))
+        {
+            executables.push_back(it->path());
+        }
+    }
+    std::sort(executables.begin(), executables.end());
+
+    std::vector<BenchHistory> histories;
+    for (auto const &executable : executables)
+    {
+        std::vector<fs::path> files;
+        for (fs::directory_iterator it(executable), end; it != end; ++it)
+        {
+            if (it->path().extension() == ".json")
+            {
+                files.push_back(it->path());
+            }
+        }
+        // the timestamp leads the file name, so the name order is the run order
+        std::sort(files.begin(), files.end());
+
+        BenchHistory history;
+        history.executable = executable.filename().string();
+        for (auto const &file : files)
+        {
+            BenchResults results;
+            std::string error;
+            if (!LoadBenchResults(file, results, error))
+            {
+                LOGWARN("skip {}: {}", file.string(), error);
+                continue;
+            }
+            auto stem = file.stem().string();
+            auto sep = stem.find('_');
+            HistoryPoint point;
+            point.timestamp = results.context.count("run_timestamp")
+                                  ? results.context["run_timestamp"]
+                                  : stem.substr(0, sep);
+            point.git_sha = results.context.count("git_sha")
+                                ? results.context["git_sha"]
+                                : (sep == std::string::npos ? "" : stem.substr(sep + 1));
+            for (auto const &run : results.runs)
+            {
+                point.time = Median(metric == "cpu_time" ? run.cpu_time : run.real_time);
+                auto &series = history.series[run.name];
+                if (series.empty())
+                {
+                    history.names.push_back(run.name);
+                }
+                series.push_back(point);
+            }
+            ++history.run_count;
+        }
+        if (history.run_count > 0)
+        {
+            histories.push_back(std::move(history));
+        }
+    }
+    return histories;
+}
+
+static double ChangePercent(double from, double to)
+{
+    return from > 0 ? (to / from - 1) * 100 : 0;
+}
+
+// the last runs drawn with the eight block characters, low is fast
+static std::string Sparkline(std::vector<HistoryPoint> const &series, size_t width)
+{
+    static const char *blocks[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    size_t first = series.size() > width ? series.size() - width : 0;
+    double low = series[first].time, high = low;
+    for (size_t i = first; i < series.size(); ++i)
+    {
+        low = std::min(low, series[i].time);
+        high = std::max(high, series[i].time);
+    }
+    std::string line;
+    for (size_t i = first; i < series.size(); ++i)
+    {
+        double level = high > low ? (series[i].time - low) / (high - low) : 0;
+        line += blocks[static_cast<size_t>(level * 7.999)];
+    }
+    return line;
+}
+
+static void PrintTextReport(std::vector<BenchHistory> const &histories)
+{
+    for (auto const &history : histories)
+    {
+        fmt::print(GREEN("{}") ", {} run(s)\n", history.executable, history.run_count);
+        size_t width = 9;
+        for (auto const &name : history.names)
+        {
+            width = std::max(width, name.size());
+        }
+        fmt::print("  {:<{}}  {:<20}  {:>12}  {:>9}  {:>9}\n", "benchmark", width, "trend",
+            "latest", "previous", "first");
+        for (auto const &name : history.names)
+        {
+            auto const &series = history.series.at(name);
+            auto const &latest = series.back();
+            double vs_previous =
+                series.size() > 1 ? ChangePercent(series[series.size() - 2].time, latest.time) : 0;
+            double vs_first = ChangePercent(series.front().time, latest.time);
+            auto trend = Sparkline(series, 20);
+            // the block characters are one column but three bytes wide
+            trend.append(20 - std::min<size_t>(20, series.size()), ' ');
+            fmt::print("  {:<{}}  {}  {:>12}  {:>+8.2f}%  {:>+8.2f}%\n", name, width, trend,
+                FormatTime(latest.time), vs_previous, vs_first);
+        }
+        fmt::print("\n");
+    }
+}
+
+static std::string HtmlEscape(std::string const &text)
+{
+    std::string out;
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '<':
+            out += "&lt;";
+            break;
+        case '>':
+            out += "&gt;";
+            break;
+        case '&':
+            out += "&amp;";
+            break;
+        case '"':
+            out += "&quot;";
+            break;
+        default:
+            out += c;
+        }
+    }
+    return out;
+}
+
+// a polyline of the runs, every point tells its revision and time on hover
+static std::string SvgTrend(std::vector<HistoryPoint> const &series)
+{
+    const double width = 360, height = 60, pad = 4;
+    double low = series.front().time, high = low;
+    for (auto const &point : series)
+    {
+        low = std::min(low, point.time);
+        high = std::max(high, point.time);
+    }
+    auto x = [&](size_t i) {
+        return series.size() > 1 ? pad + i * (width - 2 * pad) / (series.size() - 1) : width / 2;
+    };
+    auto y = [&](double time) {
+        return high > low ? height - pad - (time - low) / (high - low) * (height - 2 * pad)
+                          : height / 2;
+    };
+
+    std::string svg = fmt::format(
+        "<svg width=\"{0}\" height=\"{1}\" viewBox=\"0 0 {0} {1}\"><polyline fill=\"none\" "
+        "stroke=\"#4878d0\" stroke-width=\"1.5\" points=\"",
+        width, height);
+    for (size_t i = 0; i < series.size(); ++i)
+    {
+        svg += fmt::format("{:.1f},{:.1f} ", x(i), y(series[i].time));
+    }
+    svg += "\"/>";
+    for (size_t i = 0; i < series.size(); ++i)
+    {
+        svg += fmt::format("<circle cx=\"{:.1f}\" cy=\"{:.1f}\" r=\"2.5\" fill=\"#4878d0\">"
+                           "<title>{} {} {}</title></circle>",
+            x(i), y(series[i].time), HtmlEscape(series[i].timestamp),
+            HtmlEscape(series[i].git_sha), FormatTime(series[i].time));
+    }
+    svg += "</svg>";
+    return svg;
+}
+
+static void WriteHtmlReport(std::vector<BenchHistory> const &histories, std::string const &metric,
+    fs::path const &output)
+{
+    std::string html = fmt::format(R"(<!DOCTYPE html>
+<html>
+<head>
+<meta charset="utf-8">
+<title>benchmark history</title>
+<style>
+body {{ font-family: sans-serif; margin: 2em; }}
+table {{ border-collapse: collapse; margin-bottom: 2em; }}
+th, td {{ padding: 4px 12px; border-bottom: 1px solid #ddd; text-align: right; }}
+th:first-child, td:first-child {{ text-align: left; font-family: monospace; }}
+.slower {{ color: #c03030; }}
+.faster {{ color: #208020; }}
+</style>
+</head>
+<body>
+<h1>benchmark history</h1>
+<p>median {} of every run, hover a point for its revision</p>
+)",
+        metric);
+    for (auto const &history : histories)
+    {
+        html += fmt::format("<h2>{}</h2>\n<p>{} run(s)</p>\n<table>\n<tr><th>benchmark</th>"
+                            "<th>trend</th><th>latest</th><th>vs previous</th><th>vs first</th>"
+                            "</tr>\n",
+            HtmlEscape(history.executable), history.run_count);
+        for (auto const &name : history.names)
+        {
+            auto const &series = history.series.at(name);
+            double vs_previous = series.size() > 1
+                                     ? ChangePercent(series[series.size() - 2].time,
+                                           series.back().time)
+                                     : 0;
+            double vs_first = ChangePercent(series.front().time, series.back().time);
+            auto css = [](double change) {
+                return change > 0 ? "slower" : change < 0 ? "faster" : "";
+            };
+            html += fmt::format("<tr><td>{}</td><td>{}</td><td>{}</td>"
+                                "<td class=\"{}\">{:+.2f}%</td><td class=\"{}\">{:+.2f}%</td>"
+                                "</tr>\n",
+                HtmlEscape(name), SvgTrend(series), FormatTime(series.back().time),
+                css(vs_previous), vs_previous, css(vs_first), vs_first);
+        }
+        html += "</table>\n";
+    }
+    html += "</body>\n</html>\n";
+
+    if (!WriteWholeFile(output, html))
+    {
+        LOGERR("failed to write file: {}", output.string());
+    }
+    LOGINFO("benchmark history written to {}", output.string());
+}
+
+void BenchHistoryReport()
+{
+    fs::path dir = vm.count("name") ? vm["name"].as<std::string>() : "build/bench-results";
+    if (!fs::is_directory(dir))
+    {
+        LOGERR("no benchmark history in {}, run 'cmake --build <build dir> --target "
+               "run-benchmarks' first",
+            dir.string());
+    }
+    auto metric = vm["metric"].as<std::string>();
+    CheckOptionChoice("metric", metric, {"real_time", "cpu_time"});
+    auto format = vm["format"].as<std::string>();
+    CheckOptionChoice("format", format, {"text", "html"});
+
+    auto histories = LoadHistory(dir, metric);
+    if (histories.empty())
+    {
+        LOGWARN("no benchmark result found in {}", dir.string());
+        return;
+    }
+    if (format == "html")
+    {
+        fs::path output = vm.count("output") ? fs::path(vm["output"].as<std::string>())
+                                             : dir / "history.html";
+        WriteHtmlReport(histories, metric, output);
+    }
+    else
+    {
+        PrintTextReport(histories);
+    }
+}
@@ -0,0 +1,258 @@
+#include "bench_results.h"
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace pt = boost::property_tree;
+
+BenchRun const *BenchResults::Find(std::string const &name) const
+{
+    for (auto const &run : runs)
+    {
+        if (run.name == name)
+        {
+            return &run;
+        }
+    }
+    return nullptr;
+}
+
+static double NanosecondsPer(std::string const &time_unit)
+{
+    if (time_unit == "us")
+        return 1e3;
+    if (time_unit == "ms")
+        return 1e6;
+    if (time_unit == "s")
+        return 1e9;
+    return 1;
+}
+
+bool LoadBenchResults(fs::path const &path, BenchResults &results, std::string &error)
+{
+    pt::ptree root;
+    try
+    {
+        pt::read_json(path.string(), root);
+    }
+    catch (pt::json_parser_error const &e)
+    {
+        error = e.what();
+        return false;
+    }
+
+    results = BenchResults();
+    for (auto const &entry : root.get_child("context", pt::ptree()))
+    {
+        results.context[entry.first] = entry.second.data();
+    }
+
+    std::map<std::string, size_t> index;
+    for (auto const &entry : root.get_child("benchmarks", pt::ptree()))
+    {
+        auto const &bench = entry.second;
+        if (bench.get<std::string>("run_type", "iteration") != "iteration" ||
+            bench.count("error_occurred"))
+        {
+            continue;
+        }
+        // with --benchmark_repetitions every repetition has the same run_name
+        auto name = bench.get<std::string>("run_name", bench.get<std::string>("name", ""));
+        auto scale = NanosecondsPer(bench.get<std::string>("time_unit", "ns"));
+        auto it = index.find(name);
+        if (it == index.end())
+        {
+            it = index.emplace(name, results.runs.size()).first;
+            results.runs.push_back(BenchRun{name, {}, {}});
+        }
+        auto &run = results.runs[it->second];
+        run.real_time.push_back(bench.get<double>("real_time", 0) * scale);
+        run.cpu_time.push_back(bench.get<double>("cpu_time", 0) * scale);
+    }
+    if (results.runs.empty())
+    {
+        error = "no benchmark found";
+        return false;
+    }
+    return true;
+}
+
+std::string FormatTime(double ns)
+{
+    if (ns >= 1e9)
+        return fmt::format("{:.3f} s", ns / 1e9);
+    if (ns >= 1e6)
+        return fmt::format("{:.3f} ms", ns / 1e6);
+    if (ns >= 1e3)
+        return fmt::format("{:.3f} us", ns / 1e3);
+    return fmt::format("{:.3f} ns", ns);
+}
+
+double Median(std::vector<double> values)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    if (values.size() % 2)
+    {
+        return *mid;
+    }
+    return (*mid + *std::max_element(values.begin(), mid)) / 2;
+}
+
+static double NormalCdf(double x)
+{
+    return 0.5 * std::erfc(-x / std::sqrt(2.0));
+}
+
+// bisection is plenty for the handful of quantiles a diff asks for
+static double NormalQuantile(double p)
+{
+    double low = -10, high = 10;
+    for (int i = 0; i < 100; ++i)
+    {
+        double mid = (low + high) / 2;
+        (NormalCdf(mid) < p ? low : high) = mid;
+    }
+    return (low + high) / 2;
+}
+
+// the exact null distribution is cheap to enumerate for up to this many samples in total, its
+// table grows with their count cubed, beyond it the normal approximation is close enough
+static const size_t exact_samples_limit = 40;
+
+// exact two-sided p-value of the rank sum of n1 out of the doubled (tied halves made integers)
+// ranks: the share of the n1 sized subsets of them whose sum is as far from the mean or farther.
+// n1 is the smaller sample, so the table has at most half as many rows as there are ranks
+static double ExactRankSumPValue(std::vector<long> const &doubled_ranks, size_t n1, long observed)
+{
+    long total = 0;
+    for (long rank : doubled_ranks)
+    {
+        total += rank;
+    }
+    // ways[k][s], the number of k sized subsets of the ranks seen so far summing to s
+    std::vector<std::vector<double>> ways(n1 + 1, std::vector<double>(total + 1, 0));
+    ways[0][0] = 1;
+    size_t seen = 0;
+    for (long rank : doubled_ranks)
+    {
+        ++seen;
+        for (size_t k = std::min(seen, n1); k > 0; --k)
+        {
+            for (long sum = total; sum >= rank; --sum)
+            {
+                ways[k][sum] += ways[k - 1][sum - rank];
+            }
+        }
+    }
+    long mean = static_cast<long>(n1) * (static_cast<long>(doubled_ranks.size()) + 1);
+    double extreme = 0, subsets = 0;
+    for (long sum = 0; sum <= total; ++sum)
+    {
+        subsets += ways[n1][sum];
+        if (std::labs(sum - mean) >= std::labs(observed - mean))
+        {
+            extreme += ways[n1][sum];
+        }
+    }
+    return std::min(1.0, extreme / subsets);
+}
+
+double MannWhitneyU(std::vector<double> const &a, std::vector<double> const &b)
+{
+    if (a.empty() || b.empty())
+    {
+        return 1;
+    }
+    std::vector<std::pair<double, bool>> all;
+    for (double v : a)
+        all.emplace_back(v, true);
+    for (double v : b)
+        all.emplace_back(v, false);
+    std::sort(all.begin(), all.end());
+
+    // ties share their average rank, (i + 1 + j) / 2, kept doubled for the exact test
+    double n = all.size(), tie_term = 0;
+    long rank_sum_a = 0;
+    std::vector<long> doubled_ranks;
+    doubled_ranks.reserve(all.size());
+    for (size_t i = 0; i < all.size();)
+    {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first)
+        {
+            ++j;
+        }
+        long rank = static_cast<long>(i + 1 + j);
+        for (size_t k = i; k < j; ++k)
+        {
+            rank_sum_a += all[k].second ? rank : 0;
+            doubled_ranks.push_back(rank);
+        }
+        double t = j - i;
+        tie_term += t * t * t - t;
+        i = j;
+    }
+
+    double n1 = a.size(), n2 = b.size();
+    if (all.size() <= exact_samples_limit)
+    {
+        // the doubled ranks add up to n * (n + 1), the smaller sample takes the rest when it is b
+        long rank_sum_b = static_cast<long>(n * (n + 1)) - rank_sum_a;
+        return a.size() <= b.size() ? ExactRankSumPValue(doubled_ranks, a.size(), rank_sum_a)
+                                    : ExactRankSumPValue(doubled_ranks, b.size(), rank_sum_b);
+    }
+    double u = rank_sum_a / 2.0 - n1 * (n1 + 1) / 2;
+    double mean = n1 * n2 / 2;
+    double variance = n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1)));
+    if (variance <= 0)
+    {
+        return 1;
+    }
+    // continuity correction
+    double z = std::max(0.0, std::fabs(u - mean) - 0.5) / std::sqrt(variance);
+    return std::min(1.0, 2 * (1 - NormalCdf(z)));
+}
+
+double MannWhitneyMinPValue(size_t n1, size_t n2)
+{
+    // 2 / C(n1 + n2, n1), the two fully separated orders out of all of them
+    double orders = 1;
+    for (size_t k = 1; k <= std::min(n1, n2); ++k)
+    {
+        orders = orders * (std::max(n1, n2) + k) / k;
+    }
+    return std::min(1.0, 2 / orders);
+}
+
+ShiftEstimate HodgesLehmann(
+    std::vector<double> const &a, std::vector<double> const &b, double confidence)
+{
+    std::vector<double> diffs;
+    diffs.reserve(a.size() * b.size());
+    for (double x : a)
+    {
+        for (double y : b)
+        {
+            diffs.push_back(y - x);
+        }
+    }
+    if (diffs.empty())
+    {
+        return {0, 0, 0};
+    }
+    std::sort(diffs.begin(), diffs.end());
+
+    double n1 = a.size(), n2 = b.size();
+    double z = NormalQuantile(1 - (1 - confidence) / 2);
+    double k = std::floor(n1 * n2 / 2 - z * std::sqrt(n1 * n2 * (n1 + n2 + 1) / 12));
+    size_t lower = static_cast<size_t>(std::max(0.0, k));
+    lower = std::min(lower, (diffs.size() - 1) / 2);
+    return {Median(diffs), diffs[lower], diffs[diffs.size() - 1 - lower]};
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "functions.h"
+#include <map>
+#include <vector>
+
+// the repetitions of one benchmark in a Google Benchmark JSON file, times are in nanoseconds
+struct BenchRun
+{
+    std::string name;
+    std::vector<double> real_time;
+    std::vector<double> cpu_time;
+};
+
+// a Google Benchmark JSON file, as written by --benchmark_out_format=json
+struct BenchResults
+{
+    // the "context" object, such as date, host_name and num_cpus
+    std::map<std::string, std::string> context;
+    // in the order the benchmarks first appear in the file
+    std::vector<BenchRun> runs;
+
+    BenchRun const *Find(std::string const &name) const;
+};
+
+// load the iterations of every benchmark, the aggregates (mean, median, stddev) are skipped since
+// they are computed from the same iterations, false if the file can't be read or parsed
+bool LoadBenchResults(fs::path const &path, BenchResults &results, std::string &error);
+
+// a duration in nanoseconds with the largest unit that keeps it at 1 or more, such as "1.250 ms"
+std::string FormatTime(double ns);
+
+double Median(std::vector<double> values);
+
+// two-sided Mann-Whitney U test, exact for up to 40 samples in total, beyond them with the
+// normal approximation and tie correction, returns the p-value that a and b come from the same
+// distribution, 1 if either one is empty
+double MannWhitneyU(std::vector<double> const &a, std::vector<double> const &b);
+
+// the smallest p-value MannWhitneyU can return for n1 and n2 samples, such as 0.1 for 3 and 3,
+// no difference is significant at a level below it
+double MannWhitneyMinPValue(size_t n1, size_t n2);
+
+// Hodges-Lehmann estimate of the shift from a to b, the median of all the pairwise differences
+// b[j] - a[i], with its confidence interval at the given level, such as 0.95
+struct ShiftEstimate
+{
+    double shift;
+    double low;
+    double high;
+};
+ShiftEstimate HodgesLehmann(
+    std::vector<double> const &a, std::vector<double> const &b, double confidence);
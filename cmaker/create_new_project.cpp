@@ -1,58 +1,319 @@
 #include "functions.h"
 #include "writer_funcs.h"
+#include <boost/process.hpp>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <thread>
+namespace bp = boost::process;
 
 extern po::options_description creator;
 extern po::variables_map vm;
 
-void CreateNewProject()
+static void CreateProjectsFromManifest(std::string const &manifest);
+
+// the feature flags of the build host, such as "avx2", empty if /proc/cpuinfo is not available
+static std::set<std::string> HostCpuFlags()
+{
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line))
+    {
+        if (line.compare(0, 5, "flags") == 0)
+        {
+            std::istringstream words(line.substr(line.find(':') + 1));
+            return std::set<std::string>(
+                std::istream_iterator<std::string>(words), std::istream_iterator<std::string>());
+        }
+    }
+    return {};
+}
+
+// preprocessing an empty file is enough for the compiler to reject an unknown -march
+static bool CompilerAccepts(std::string const &flag)
+{
+    const char *cxx = std::getenv("CXX");
+    auto command =
+        fmt::format("{} {} -x c++ -E -o /dev/null /dev/null", cxx && *cxx ? cxx : "c++", flag);
+    std::error_code ec;
+    return bp::system(command, bp::std_out > bp::null, bp::std_err > bp::null, ec) == 0 && !ec;
+}
+
+// the highest of x86-64-v2 and x86-64-v3 which both this host and the compiler support, probed once
+// for all the repos of a run. x86-64-v4 and native are left to an explicit --target-isa, as the
+// binaries often run on other hosts than the one building them
+static std::string DefaultTargetIsa()
+{
+    static const std::string isa = [] {
+        auto flags = HostCpuFlags();
+        auto has = [&flags](std::initializer_list<const char *> names) {
+            for (auto name : names)
+            {
+                if (!flags.count(name))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+        if (!has({"cx16", "lahf_lm", "popcnt", "sse4_1", "sse4_2", "ssse3"}) ||
+            !CompilerAccepts("-march=x86-64-v2"))
+        {
+            return std::string("baseline");
+        }
+        if (!has({"avx", "avx2", "bmi1", "bmi2", "f16c", "fma", "abm", "movbe", "xsave"}) ||
+            !CompilerAccepts("-march=x86-64-v3"))
+        {
+            return std::string("x86-64-v2");
+        }
+        return std::string("x86-64-v3");
+    }();
+    return isa;
+}
+
+// settings which are shared by every project created in one run
+static WriterContext ContextFromCommandLine()
 {
     WriterContext ctx;
+    if (vm.count("shared"))
+    {
+        ctx.repo_type = RepoType::SHARED;
+    }
+    else if (vm.count("exe"))
+    {
+        ctx.repo_type = RepoType::EXECUTABLE;
+    }
+    // has default value = 11
+    ctx.cxx_std = vm["std"].as<std::string>();
+    // has default value = MIT
+    ctx.license = vm["license"].as<std::string>();
+    if (vm.count("unity"))
+    {
+        ctx.unity_batch_size = vm["unity"].as<unsigned>();
+    }
+    ctx.pch = vm.count("pch") > 0;
+    // has default value = off
+    ctx.lto_mode = vm["lto"].as<std::string>();
+    CheckOptionChoice("lto", ctx.lto_mode, {"off", "full", "thin"});
+    // has default value = auto
+    ctx.linker = vm["linker"].as<std::string>();
+    CheckOptionChoice("linker", ctx.linker, {"auto", "mold", "lld", "gold", "default"});
+    // has default value = system
+    ctx.allocator = vm["allocator"].as<std::string>();
+    CheckOptionChoice("allocator", ctx.allocator, {"system", "jemalloc", "mimalloc", "tcmalloc"});
+    // has default value = auto
+    ctx.target_isa = vm["target-isa"].as<std::string>();
+    CheckOptionChoice("target-isa", ctx.target_isa,
+        {"auto", "baseline", "x86-64-v2", "x86-64-v3", "x86-64-v4", "native"});
+    if (ctx.target_isa == "auto")
+    {
+        ctx.target_isa = DefaultTargetIsa();
+        LOGINFO("target ISA: {}, pass --target-isa to choose another one", ctx.target_isa);
+    }
+    return ctx;
+}
+
+// the generated repos pick up a compiler cache by themselves, tell the user if there is none
+static void WarnIfNoCompilerCache()
+{
+    if (!IsExecutableInPath("ccache") && !IsExecutableInPath("sccache"))
+    {
+        LOGWARN("neither " GREEN("ccache") " nor " GREEN("sccache") " is found, install one of "
+                "them to let the generated repos cache their compilations");
+    }
+}
+
+void CreateNewProject()
+{
+    if (vm.count("manifest"))
+    {
+        CreateProjectsFromManifest(vm["manifest"].as<std::string>());
+        return;
+    }
+
+    WriterContext ctx = ContextFromCommandLine();
     if (!vm.count("name"))
     {
         LOGERR("missing repo name for creating project");
         PrintUsageAndQuit(creator);
     }
-    ctx.repo_name = vm["name"].as<std::string>();
-    if (vm.count("shared"))
+    ctx.SetRepoName(vm["name"].as<std::string>());
+    ctx.root_dir = ctx.repo_name;
+    if (RepoType::SHARED == ctx.repo_type)
     {
         LOGINFO("creating repo for shared library: {}", ctx.repo_name);
-        ctx.repo_type = RepoType::SHARED;
     }
-    else if (vm.count("exe"))
+    else if (RepoType::EXECUTABLE == ctx.repo_type)
     {
         LOGINFO("creating repo for executable: {}", ctx.repo_name);
-        ctx.repo_type = RepoType::EXECUTABLE;
     }
     else
     {
         LOGINFO("creating repo for static library: {}", ctx.repo_name);
     }
-    // has default value = 11
-    ctx.cxx_std = vm["std"].as<std::string>();
-    // has default value = MIT
-    ctx.license = vm["license"].as<std::string>();
 
-    if (!CreateDirIfNotExist(ctx.repo_name))
+    WriteProject(ctx);
+    WarnIfNoCompilerCache();
+}
+
+void WriteProject(WriterContext const &project)
+{
+    // the manifest of the scaffold files is written once, after all of them
+    WriterContext ctx = project;
+    GeneratedHashes generated;
+    ctx.generated = &generated;
+
+    if (!CreateDirIfNotExist(ctx.root_dir.string(), ctx.verbose))
     {
         LOGERR("abort!");
         exit(1);
     }
 
-    // with chdir to
+    CreateDirIfNotExist((ctx.root_dir / ctx.repo_name).string(), ctx.verbose);
+    CreateDirIfNotExist((ctx.root_dir / "cmake_modules").string(), ctx.verbose);
+    CreateDirIfNotExist((ctx.root_dir / "thirdparty").string(), ctx.verbose);
+    CreateDirIfNotExist((ctx.root_dir / "unit_test").string(), ctx.verbose);
+    CreateDirIfNotExist((ctx.root_dir / "bench").string(), ctx.verbose);
+    WriteCMakeLists(ctx);
+    WriteUnitTests(ctx);
+    WriteBenchmark(ctx);
+    WriteSrcAndHeader(ctx);
+    WriteSources(ctx);
+    WriteGitignore(ctx);
+    WriteClangformat(ctx);
+    WriteClangTidy(ctx);
+    WriteLicense(ctx);
+    WriteCMakePresets(ctx);
+    WriteReadme(ctx);
+    SaveGeneratedHashes(ctx);
+
+    // no shell and no chdir, so it is safe to run from the worker threads of batch mode
+    bp::system(fmt::format("git init {} \"{}\"", ctx.verbose ? "" : "-q", ctx.root_dir.string()));
+}
+
+// manifest line format, columns are separated by spaces or tabs:
+//     path/to/name [static|shared|exe] [std] [license]
+// omitted columns or '-' fall back to the command line options, '#' starts a comment
+static bool ParseManifestLine(std::string line, WriterContext &ctx)
+{
+    auto comment = line.find('#');
+    if (comment != std::string::npos)
+    {
+        line.erase(comment);
+    }
+    std::istringstream columns(line);
+    std::string path, type, cxx_std, license;
+    if (!(columns >> path))
+    {
+        return false;
+    }
+    columns >> type >> cxx_std >> license;
+
+    ctx.root_dir = path;
+    ctx.SetRepoName(ctx.root_dir.filename().string());
+    if (type == "static")
+    {
+        ctx.repo_type = RepoType::STATIC;
+    }
+    else if (type == "shared")
+    {
+        ctx.repo_type = RepoType::SHARED;
+    }
+    else if (type == "exe")
+    {
+        ctx.repo_type = RepoType::EXECUTABLE;
+    }
+    else if (!type.empty() && type != "-")
+    {
+        LOGERR("invalid repo type '{}' for {} in manifest, expects static, shared or exe", type,
+            path);
+    }
+    if (!cxx_std.empty() && cxx_std != "-")
+    {
+        ctx.cxx_std = cxx_std;
+    }
+    if (!license.empty() && license != "-")
+    {
+        ctx.license = license;
+    }
+    return true;
+}
+
+static void CreateProjectsFromManifest(std::string const &manifest)
+{
+    std::ifstream input(manifest);
+    if (!input)
     {
-        PushD _(ctx.repo_name);
+        LOGERR("failed to open manifest: {}", manifest);
+    }
 
-        CreateDirIfNotExist(ctx.repo_name);
-        CreateDirIfNotExist("cmake_modules");
-        CreateDirIfNotExist("thirdparty");
-        WriteCMakeLists(ctx);
-        WriteSrcAndHeader(ctx);
-        WriteGitignore();
-        WriteClangformat();
-        WriteClangTidy();
-        WriteLicense(ctx);
-        WriteReadme(ctx);
+    WriterContext defaults = ContextFromCommandLine();
+    defaults.verbose = false;
 
-        std::system("git init");
+    std::vector<WriterContext> projects;
+    std::set<std::string> seen;
+    std::string line;
+    while (std::getline(input, line))
+    {
+        WriterContext ctx = defaults;
+        if (!ParseManifestLine(line, ctx))
+        {
+            continue;
+        }
+        if (ctx.repo_name.empty() || ctx.repo_name == "." || ctx.repo_name == "..")
+        {
+            LOGWARN("skip {}: invalid repo name", ctx.root_dir.string());
+            continue;
+        }
+        if (!seen.insert(ctx.root_dir.lexically_normal().string()).second)
+        {
+            LOGWARN("skip {}: listed more than once", ctx.root_dir.string());
+            continue;
+        }
+        if (fs::exists(ctx.root_dir))
+        {
+            LOGWARN("skip {}: directory already exists", ctx.root_dir.string());
+            continue;
+        }
+        projects.push_back(ctx);
     }
+    if (projects.empty())
+    {
+        LOGWARN("no project to create in manifest {}", manifest);
+        return;
+    }
+
+    unsigned jobs = vm["jobs"].as<unsigned>();
+    if (jobs == 0)
+    {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    jobs = std::min<unsigned>(jobs, projects.size());
+    LOGINFO("creating {} projects from {} with {} threads", projects.size(), manifest, jobs);
+
+    auto start = std::chrono::steady_clock::now();
+    // every worker keeps pulling the next project until the list is drained
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < jobs; ++i)
+    {
+        workers.emplace_back([&projects, &next]() {
+            for (size_t idx = next++; idx < projects.size(); idx = next++)
+            {
+                WriteProject(projects[idx]);
+                LOGINFO("created {}", projects[idx].root_dir.string());
+            }
+        });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    LOGINFO("created {} projects in {:.3f}s, {:.1f} projects/s", projects.size(), elapsed.count(),
+        projects.size() / elapsed.count());
+    WarnIfNoCompilerCache();
 }
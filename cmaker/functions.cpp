@@ -1,5 +1,6 @@
 #include "functions.h"
 #include <boost/tokenizer.hpp>
+#include <fmt/ranges.h>
 
 const char *GetVersionString()
 {
@@ -10,7 +11,7 @@ const char *GetVersionString()
 #undef XX
 }
 
-bool CreateDirIfNotExist(std::string name)
+bool CreateDirIfNotExist(std::string name, bool verbose)
 {
     if (fs::exists(name))
     {
@@ -23,7 +24,8 @@ bool CreateDirIfNotExist(std::string name)
         LOGERR("directory {} create failed! reason: {}", name, ec.message());
         return false;
     }
-    LOGINFO("directory {} created!", name);
+    if (verbose)
+        LOGINFO("directory {} created!", name);
     return true;
 }
 
@@ -40,7 +42,12 @@ bool IsUnderCurrentDirectory(fs::path const &path)
 
 bool IsExecutableInPath(std::string exe)
 {
-    std::string path_env = std::getenv("PATH");
+    const char *env = std::getenv("PATH");
+    if (!env)
+    {
+        return false;
+    }
+    std::string path_env = env;
     // PATH delimeter in LINUX is ':' and in WIN is ';'
     boost::char_separator<char> delim(":;");
     boost::tokenizer<boost::char_separator<char>> tokens(path_env, delim);
@@ -112,4 +119,40 @@ std::string Pascalization(std::string str)
     }
 
     return result;
-}
\ No newline at end of file
+}
+
+bool ParseSystemInclude(std::string const &line, std::string &header)
+{
+    auto pos = line.find_first_not_of(" \t");
+    if (pos == std::string::npos || line[pos] != '#')
+    {
+        return false;
+    }
+    pos = line.find_first_not_of(" \t", pos + 1);
+    if (pos == std::string::npos || line.compare(pos, 7, "include") != 0)
+    {
+        return false;
+    }
+    pos = line.find_first_not_of(" \t", pos + 7);
+    if (pos == std::string::npos || line[pos] != '<')
+    {
+        return false;
+    }
+    auto end = line.find('>', pos + 1);
+    if (end == std::string::npos || end == pos + 1)
+    {
+        return false;
+    }
+    header = line.substr(pos + 1, end - pos - 1);
+    return true;
+}
+
+void CheckOptionChoice(
+    std::string const &option, std::string const &value, std::vector<std::string> const &choices)
+{
+    if (std::find(choices.begin(), choices.end(), value) == choices.end())
+    {
+        LOGERR("invalid value '{}' for --{}, supported values: {}", value, option,
+            fmt::join(choices, ", "));
+    }
+}
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 
 #ifdef USE_BOOST_FILESYSTEM
 #include <boost/filesystem.hpp>
@@ -42,14 +43,22 @@ void PrintUsageAndQuit(po::options_description &des, int errc = 1);
 const char *GetVersionString();
 const char *GetLicense();
 void CreateNewProject();
+void RegenProject();
+void SyncProject();
+void WatchProject();
 void AddThirdpartyLibrary();
 void AddSubmodule();
 void AddBench();
+void AddMachineBench();
+void AddSimd();
 void AddTests();
 void AddTemplate();
+void ManagePch();
+void BenchDiff();
+void BenchHistoryReport();
 
 // true on success false on fail (exists)
-bool CreateDirIfNotExist(std::string name);
+bool CreateDirIfNotExist(std::string name, bool verbose = true);
 
 // check if current working directoy is the root directory of project
 bool IsProjectRoot();
@@ -65,6 +74,13 @@ bool PromptUserConfirm();
 // convert string into Pascal Case naming style
 std::string Pascalization(std::string str);
 
+// validate an option value which only accepts the listed choices, abort on invalid value
+void CheckOptionChoice(std::string const &option, std::string const &value,
+    std::vector<std::string> const &choices);
+
+// extract "vector" from a line like "#include <vector>", false if it is not a system include
+bool ParseSystemInclude(std::string const &line, std::string &header);
+
 inline std::string ToUpper(std::string str)
 {
     std::transform(str.begin(), str.end(), str.begin(), [](int c) { return std::toupper(c); });
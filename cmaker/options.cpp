@@ -0,0 +1,25 @@
+#include "functions.h"
+
+// the command line options are defined apart from main(), so the operations in the cmaker
+// objects link into the unit tests as well
+po::options_description all(fmt::format(
+    GREEN("\"CMaker\"") " ({}) is A CMakeLists.txt generater helper.\n"
+                        "The program will help you create a repo based on CMake build system "
+                        "with ease.\n"
+                        "You don't have to remember all those obscure syntax and commands.\n"
+                        "Start coding in just one command. All the common features of CMake "
+                        "will be added in\n"
+                        "the well-elaborated CMakeLists.txt template, along with GTest and "
+                        "benchmark examples.\n"
+                        "Here are the allowed options",
+    GetVersionString()));
+po::options_description general(BLUE("general options"));
+po::options_description creator(BLUE("create a new repo"));
+po::options_description adder_library(BLUE("add thirdparty library"));
+po::options_description adder_module(BLUE("add submodule"));
+po::options_description adder_template(BLUE("add benchmark or gtest template"));
+po::options_description pch_tools(BLUE("precompiled header tools"));
+po::options_description watcher(BLUE("watch the sources and rebuild"));
+po::options_description bench_tools(BLUE("benchmark result tools"));
+po::positional_options_description pos_desc;
+po::variables_map vm;
@@ -0,0 +1,136 @@
+#include "functions.h"
+#include "writer_funcs.h"
+#include <map>
+#include <set>
+
+extern po::options_description pch_tools;
+extern po::variables_map vm;
+
+static bool IsSourceFile(fs::path const &path)
+{
+    static const std::set<std::string> extensions = {
+        ".c", ".cc", ".cpp", ".cxx", ".h", ".hh", ".hpp", ".hxx"};
+    return extensions.count(path.extension().string()) > 0;
+}
+
+// build outputs, vcs metadata and vendored code do not tell what the repo itself includes
+static bool IsSkippedDir(fs::path const &path)
+{
+    auto name = path.filename().string();
+    return name.empty() || name[0] == '.' || name.compare(0, 5, "build") == 0 ||
+           name == "thirdparty" || name == "cmake_modules";
+}
+
+// count how many source files of the main target include each system header, print the most
+// included ones as a PROJECT_PCH_HEADERS list. unit_test and bench add gtest and benchmark to
+// their own precompiled headers, their includes would only crowd out the library's
+static void SuggestPch()
+{
+    WriterContext ctx;
+    if (!LoadWriterContext(".", ctx))
+    {
+        LOGERR("no project() found in CMakeLists.txt, the repo is not created by cmaker");
+    }
+    if (!fs::is_directory(ctx.repo_name))
+    {
+        LOGERR("no {}/ directory of the main target sources", ctx.repo_name);
+    }
+
+    std::map<std::string, size_t> counts;
+    size_t files = 0;
+    fs::recursive_directory_iterator it(ctx.repo_name), end;
+    for (; it != end; ++it)
+    {
+        auto const &path = it->path();
+        if (fs::is_directory(path))
+        {
+            if (IsSkippedDir(path))
+            {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (!IsSourceFile(path))
+        {
+            continue;
+        }
+
+        std::ifstream source(path.string());
+        std::set<std::string> headers;
+        std::string line, header;
+        while (std::getline(source, line))
+        {
+            if (ParseSystemInclude(line, header))
+            {
+                headers.insert(header);
+            }
+        }
+        for (auto const &h : headers)
+        {
+            ++counts[h];
+        }
+        ++files;
+    }
+
+    std::vector<std::pair<std::string, size_t>> ranking;
+    for (auto const &count : counts)
+    {
+        // a header included by a single file gains nothing from precompiling, and the repo's own
+        // headers change too often to be precompiled
+        if (count.second < 2 || fs::exists(count.first) ||
+            fs::exists(fs::path(ctx.repo_name) / count.first))
+        {
+            continue;
+        }
+        ranking.push_back(count);
+    }
+    std::sort(ranking.begin(), ranking.end(),
+        [](std::pair<std::string, size_t> const &a, std::pair<std::string, size_t> const &b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+    auto top = vm["top"].as<size_t>();
+    if (ranking.size() > top)
+    {
+        ranking.resize(top);
+    }
+
+    if (ranking.empty())
+    {
+        LOGWARN("scanned {} source files of {}/, no system header is included by two of them",
+            files, ctx.repo_name);
+        return;
+    }
+    LOGINFO("scanned {} source files of {}/, replace PROJECT_PCH_HEADERS in CMakeLists.txt with:",
+        files, ctx.repo_name);
+    fmt::print("set(PROJECT_PCH_HEADERS\n");
+    for (auto const &entry : ranking)
+    {
+        fmt::print("    {:<32} # included by {} of {} files\n", "<" + entry.first + ">",
+            entry.second, files);
+    }
+    fmt::print("    )\n");
+}
+
+void ManagePch()
+{
+    if (!IsProjectRoot())
+    {
+        LOGERR("Opration 'pch' MUST be called under the project root!");
+    }
+    if (vm.count("name") == 0 || vm["name"].as<std::string>() == "help")
+    {
+        LOGINFO("Available pch operations:");
+        fmt::print("    [suggest]\n");
+        std::cout << pch_tools;
+        return;
+    }
+    auto name = vm["name"].as<std::string>();
+    if (name == "suggest")
+    {
+        SuggestPch();
+    }
+    else
+    {
+        LOGERR("pch operation not supported: {}", name);
+    }
+}
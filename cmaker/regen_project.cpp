@@ -0,0 +1,228 @@
+#include "functions.h"
+#include "writer_funcs.h"
+#include <chrono>
+
+extern po::options_description creator;
+extern po::variables_map vm;
+
+// the word following the first occurrence of prefix, such as "mylib" for "project(" in
+// "project(mylib LANGUAGES ...)", or "thin" for "set(LTO_MODE \"" in "set(LTO_MODE \"thin\" ...)",
+// empty if prefix is not found
+static std::string WordAfter(std::string const &text, std::string const &prefix)
+{
+    auto pos = text.find(prefix);
+    if (pos == std::string::npos)
+    {
+        return "";
+    }
+    pos += prefix.size();
+    auto end = text.find_first_of(" \t\r\n)\"", pos);
+    return text.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+}
+
+bool LoadWriterContext(fs::path const &root, WriterContext &ctx)
+{
+    std::ifstream cmakelist((root / "CMakeLists.txt").string());
+    if (!cmakelist)
+    {
+        return false;
+    }
+    std::string text(
+        (std::istreambuf_iterator<char>(cmakelist)), std::istreambuf_iterator<char>());
+
+    auto name = WordAfter(text, "project(");
+    if (name.empty())
+    {
+        return false;
+    }
+    ctx.SetRepoName(name);
+    ctx.root_dir = root;
+
+    if (text.find("add_executable(${PROJECT_NAME}") != std::string::npos)
+    {
+        ctx.repo_type = RepoType::EXECUTABLE;
+    }
+    else if (text.find("add_library(${PROJECT_NAME} SHARED") != std::string::npos)
+    {
+        ctx.repo_type = RepoType::SHARED;
+    }
+    else
+    {
+        ctx.repo_type = RepoType::STATIC;
+    }
+
+    auto cxx_std = WordAfter(text, "set(CMAKE_CXX_STANDARD ");
+    if (!cxx_std.empty())
+    {
+        ctx.cxx_std = cxx_std;
+    }
+
+    auto unity_batch_size = WordAfter(text, "set(UNITY_BUILD_BATCH_SIZE ");
+    if (!unity_batch_size.empty())
+    {
+        ctx.unity_batch_size = std::stoul(unity_batch_size);
+    }
+    ctx.pch = text.find("option(ENABLE_PCH ") != std::string::npos;
+
+    auto lto_mode = WordAfter(text, "set(LTO_MODE \"");
+    if (!lto_mode.empty())
+    {
+        ctx.lto_mode = lto_mode;
+    }
+    auto linker = WordAfter(text, "set(FAST_LINKER \"");
+    if (!linker.empty())
+    {
+        ctx.linker = linker;
+    }
+    auto allocator = WordAfter(text, "set(ALLOCATOR \"");
+    if (!allocator.empty())
+    {
+        ctx.allocator = allocator;
+    }
+    auto target_isa = WordAfter(text, "set(TARGET_ISA \"");
+    if (!target_isa.empty())
+    {
+        ctx.target_isa = target_isa;
+    }
+    return true;
+}
+
+// the settings of the repo given as the operand of the operation, or of the current directory
+static WriterContext LoadOperandRepo()
+{
+    fs::path root = vm.count("name") ? vm["name"].as<std::string>() : ".";
+    WriterContext ctx;
+    if (!LoadWriterContext(root, ctx))
+    {
+        LOGERR("{} is not a repo created by cmaker, no project() found in its CMakeLists.txt",
+            fs::absolute(root).string());
+    }
+    return ctx;
+}
+
+void RegenProject()
+{
+    WriterContext ctx = LoadOperandRepo();
+    auto const &root = ctx.root_dir;
+
+    // options given explicitly on the command line win over the ones read from the repo
+    if (vm.count("static"))
+    {
+        ctx.repo_type = RepoType::STATIC;
+    }
+    else if (vm.count("shared"))
+    {
+        ctx.repo_type = RepoType::SHARED;
+    }
+    else if (vm.count("exe"))
+    {
+        ctx.repo_type = RepoType::EXECUTABLE;
+    }
+    if (!vm["std"].defaulted())
+    {
+        ctx.cxx_std = vm["std"].as<std::string>();
+    }
+    if (vm.count("unity"))
+    {
+        ctx.unity_batch_size = vm["unity"].as<unsigned>();
+    }
+    if (vm.count("pch"))
+    {
+        ctx.pch = true;
+    }
+    if (!vm["lto"].defaulted())
+    {
+        ctx.lto_mode = vm["lto"].as<std::string>();
+        CheckOptionChoice("lto", ctx.lto_mode, {"off", "full", "thin"});
+    }
+    if (!vm["linker"].defaulted())
+    {
+        ctx.linker = vm["linker"].as<std::string>();
+        CheckOptionChoice("linker", ctx.linker, {"auto", "mold", "lld", "gold", "default"});
+    }
+    if (!vm["allocator"].defaulted())
+    {
+        ctx.allocator = vm["allocator"].as<std::string>();
+        CheckOptionChoice(
+            "allocator", ctx.allocator, {"system", "jemalloc", "mimalloc", "tcmalloc"});
+    }
+    if (!vm["target-isa"].defaulted())
+    {
+        ctx.target_isa = vm["target-isa"].as<std::string>();
+        CheckOptionChoice("target-isa", ctx.target_isa,
+            {"baseline", "x86-64-v2", "x86-64-v3", "x86-64-v4", "native"});
+    }
+
+    RegenSummary summary;
+    summary.overwrite_edited = vm.count("force") > 0;
+    ctx.regen = &summary;
+    GeneratedHashes generated;
+    ctx.generated = &generated;
+    ctx.verbose = false;
+    LOGINFO("regenerating repo {} in {}", ctx.repo_name, fs::absolute(root).string());
+
+    WriteCMakeLists(ctx);
+    WriteSources(ctx);
+    if (fs::is_directory(root / "unit_test"))
+    {
+        WriteUnitTests(ctx);
+    }
+    if (fs::is_directory(root / "bench"))
+    {
+        WriteBenchmark(ctx);
+    }
+    WriteGitignore(ctx);
+    WriteClangformat(ctx);
+    WriteClangTidy(ctx);
+    WriteCMakePresets(ctx);
+    SaveGeneratedHashes(ctx);
+
+    for (auto const &file : summary.changed)
+    {
+        LOGINFO(YELLOW("changed") "   {}", file);
+    }
+    for (auto const &file : summary.unchanged)
+    {
+        LOGINFO(GREEN("unchanged") " {}", file);
+    }
+    for (auto const &file : summary.edited)
+    {
+        LOGINFO(RED("edited") "    {}", file);
+    }
+    LOGINFO("{} file(s) changed, {} file(s) unchanged", summary.changed.size(),
+        summary.unchanged.size());
+    if (!summary.edited.empty())
+    {
+        LOGWARN("{} file(s) edited by hand are kept, merge the differences above into them, or "
+                "overwrite them with 'cmaker regen --force'",
+            summary.edited.size());
+    }
+}
+
+void SyncProject()
+{
+    auto start = std::chrono::steady_clock::now();
+    WriterContext ctx = LoadOperandRepo();
+    RegenSummary summary;
+    ctx.regen = &summary;
+    GeneratedHashes generated;
+    ctx.generated = &generated;
+    ctx.verbose = false;
+
+    // an unchanged list keeps the mtime of sources.cmake, so the next build won't rerun cmake
+    WriteSources(ctx);
+    SaveGeneratedHashes(ctx);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (!summary.edited.empty())
+    {
+        LOGWARN("sources.cmake is kept, 'cmaker regen --force' overwrites it");
+    }
+    else if (summary.changed.empty())
+    {
+        LOGINFO("sources.cmake is " GREEN("up to date") ", scanned in {:.1f}ms", elapsed.count());
+    }
+    else
+    {
+        LOGINFO("sources.cmake " YELLOW("updated") ", scanned in {:.1f}ms", elapsed.count());
+    }
+}
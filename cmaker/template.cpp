@@ -0,0 +1,165 @@
+#include "template.h"
+#include "writer_funcs.h"
+#include <cstdio>
+
+Template::Template(std::string text)
+    : source(std::move(text))
+{
+    static const struct
+    {
+        const char *name;
+        Var var;
+    } names[] = {
+        {"repo_name", Var::REPO_NAME},
+        {"REPO_NAME", Var::REPO_NAME_UPPER},
+        {"cxx_std", Var::CXX_STD},
+        {"license", Var::LICENSE},
+        {"library_type", Var::LIBRARY_TYPE},
+        {"unity_batch_size", Var::UNITY_BATCH_SIZE},
+        {"lto_mode", Var::LTO_MODE},
+        {"linker", Var::LINKER},
+        {"allocator", Var::ALLOCATOR},
+        {"target_isa", Var::TARGET_ISA},
+    };
+
+    size_t pos = 0;
+    while (pos < source.size())
+    {
+        size_t open = source.find("{{", pos);
+        if (open == std::string::npos)
+        {
+            break;
+        }
+        // "${{{REPO_NAME}}" keeps the cmake brace as text
+        while (open + 2 < source.size() && source[open + 2] == '{')
+        {
+            ++open;
+        }
+        size_t close = source.find("}}", open + 2);
+        if (close == std::string::npos)
+        {
+            LOGERR("unterminated template variable at offset {}", open);
+        }
+
+        std::string name = source.substr(open + 2, close - open - 2);
+        Var var = Var::NONE;
+        for (auto const &entry : names)
+        {
+            if (name == entry.name)
+            {
+                var = entry.var;
+                break;
+            }
+        }
+        if (Var::NONE == var)
+        {
+            LOGERR("unknown template variable: {{{{{}}}}}", name);
+        }
+
+        if (open > pos)
+        {
+            tokens.push_back({pos, open - pos, Var::NONE});
+            literal_size += open - pos;
+        }
+        tokens.push_back({0, 0, var});
+        pos = close + 2;
+    }
+    if (pos < source.size())
+    {
+        tokens.push_back({pos, source.size() - pos, Var::NONE});
+        literal_size += source.size() - pos;
+    }
+}
+
+void Template::RenderTo(std::string &out, WriterContext const &ctx) const
+{
+    out.reserve(out.size() + literal_size + 16 * tokens.size());
+    for (auto const &tok : tokens)
+    {
+        switch (tok.var)
+        {
+        case Var::NONE:
+            out.append(source, tok.offset, tok.size);
+            break;
+        case Var::REPO_NAME:
+            out += ctx.repo_name;
+            break;
+        case Var::REPO_NAME_UPPER:
+            out += ctx.upper_name;
+            break;
+        case Var::CXX_STD:
+            out += ctx.cxx_std;
+            break;
+        case Var::LICENSE:
+            out += ctx.license;
+            break;
+        case Var::LIBRARY_TYPE:
+            out += RepoType::SHARED == ctx.repo_type ? "SHARED" : "STATIC";
+            break;
+        case Var::UNITY_BATCH_SIZE:
+            out += std::to_string(ctx.unity_batch_size);
+            break;
+        case Var::LTO_MODE:
+            out += ctx.lto_mode;
+            break;
+        case Var::LINKER:
+            out += ctx.linker;
+            break;
+        case Var::ALLOCATOR:
+            out += ctx.allocator;
+            break;
+        case Var::TARGET_ISA:
+            out += ctx.target_isa;
+            break;
+        }
+    }
+}
+
+std::string Template::Render(WriterContext const &ctx) const
+{
+    std::string out;
+    RenderTo(out, ctx);
+    return out;
+}
+
+bool WriteWholeFile(fs::path const &path, std::string const &content)
+{
+    std::FILE *file = std::fopen(path.string().c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    // unbuffered, so the whole content goes down in one write instead of BUFSIZ sized chunks
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    bool ok = std::fwrite(content.data(), 1, content.size(), file) == content.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+std::uint64_t ContentHash(std::string const &content)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : content)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool IsFileContentSame(fs::path const &path, std::string const &content)
+{
+    error_code ec;
+    // a different size is a different content, no need to read the file
+    auto size = fs::file_size(path, ec);
+    if (ec || size != content.size())
+    {
+        return false;
+    }
+    std::ifstream file(path.string(), std::ios::binary);
+    std::string on_disk(size, '\0');
+    if (!file.read(&on_disk[0], size))
+    {
+        return false;
+    }
+    return on_disk == content;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "functions.h"
+#include <cstdint>
+#include <vector>
+
+struct WriterContext;
+
+// A text template parsed once into literal and variable tokens, then rendered into a caller
+// owned buffer as many times as needed. Variables are written as {{name}}, supported names:
+//     repo_name     the repo name
+//     REPO_NAME     the upper cased repo name, for macros and cmake variables
+//     cxx_std       the c++ standard version
+//     license       the license name
+//     library_type  STATIC or SHARED
+//     unity_batch_size  number of sources merged into one unity batch
+//     lto_mode      link-time optimization mode: off, full or thin
+//     linker        default linker: auto, mold, lld, gold or default
+//     allocator     default heap allocator: system, jemalloc, mimalloc or tcmalloc
+//     target_isa    default instruction set: baseline, x86-64-v2, x86-64-v3, x86-64-v4 or native
+// A run of more than two braces leaves the leading ones as text, so "${{{REPO_NAME}}_X}"
+// renders as "${MYLIB_X}".
+class Template
+{
+public:
+    explicit Template(std::string text);
+
+    // append the rendered text to out
+    void RenderTo(std::string &out, WriterContext const &ctx) const;
+
+    std::string Render(WriterContext const &ctx) const;
+
+private:
+    enum class Var
+    {
+        NONE, // literal text
+        REPO_NAME,
+        REPO_NAME_UPPER,
+        CXX_STD,
+        LICENSE,
+        LIBRARY_TYPE,
+        UNITY_BATCH_SIZE,
+        LTO_MODE,
+        LINKER,
+        ALLOCATOR,
+        TARGET_ISA,
+    };
+
+    struct Token
+    {
+        size_t offset;
+        size_t size;
+        Var var;
+    };
+
+    std::string source;
+    std::vector<Token> tokens;
+    // total size of the literal tokens, used to reserve the output buffer
+    size_t literal_size{0};
+};
+
+// write the whole content with a single unbuffered write, true on success
+bool WriteWholeFile(fs::path const &path, std::string const &content);
+
+// 64-bit FNV-1a hash of the content
+std::uint64_t ContentHash(std::string const &content);
+
+// true if the file exists and its content is the same as the given content
+bool IsFileContentSame(fs::path const &path, std::string const &content);
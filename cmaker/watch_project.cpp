@@ -0,0 +1,294 @@
+#include "functions.h"
+#include "writer_funcs.h"
+#include <boost/process.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+namespace bp = boost::process;
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+extern po::variables_map vm;
+
+#ifdef __linux__
+// sources and headers, editor swap files and build outputs do not start a build
+static bool IsWatchedFile(std::string const &name)
+{
+    static const std::set<std::string> extensions = {
+        ".c", ".cc", ".cpp", ".cxx", ".h", ".hh", ".hpp", ".hxx", ".inl", ".txt", ".cmake"};
+    return !name.empty() && name[0] != '.' && extensions.count(fs::path(name).extension().string());
+}
+
+static bool IsSourceName(std::string const &name)
+{
+    static const std::set<std::string> extensions = {".c", ".cc", ".cpp", ".cxx"};
+    return extensions.count(fs::path(name).extension().string()) > 0;
+}
+
+// what one debounced batch of events touched
+struct ChangeBatch
+{
+    std::chrono::steady_clock::time_point first_event;
+    // a source file was created, deleted or renamed, the source lists need a sync
+    bool structural{false};
+    // files changed under <repo>/, everything linking the main target has to be rebuilt
+    bool main_target{false};
+    // cmake targets named after the changed test and benchmark sources
+    std::set<std::string> targets;
+    // a header or a cmake file changed in unit_test/ or bench/, no single target to pick
+    bool whole_build{false};
+
+    // no event that matters to the build, first_event is not set then
+    bool Empty() const { return !structural && !main_target && targets.empty() && !whole_build; }
+};
+
+class Watcher
+{
+public:
+    explicit Watcher(WriterContext const &ctx)
+        : ctx(ctx)
+        , fd(inotify_init1(IN_CLOEXEC))
+    {
+        if (fd < 0)
+        {
+            LOGERR("inotify_init1 failed: {}", std::strerror(errno));
+        }
+    }
+
+    ~Watcher() { close(fd); }
+
+    // UNIT_TEST_MODE=consolidated of the build dir, every test source builds unit_tests
+    bool consolidated_tests{false};
+
+    // watch dir and every directory below it
+    void AddTree(std::string const &dir)
+    {
+        if (!fs::is_directory(ctx.root_dir / dir))
+        {
+            return;
+        }
+        AddDir(dir);
+        error_code ec;
+        fs::recursive_directory_iterator it(ctx.root_dir / dir, ec), end;
+        for (; !ec && it != end; it.increment(ec))
+        {
+            if (fs::is_directory(it->path()))
+            {
+                AddDir(it->path().lexically_relative(ctx.root_dir).generic_string());
+            }
+        }
+    }
+
+    // block until the first event, then keep collecting until nothing arrives for debounce_ms
+    ChangeBatch WaitForChanges(int debounce_ms)
+    {
+        ChangeBatch batch;
+        bool relevant = false;
+        int timeout = -1;
+        pollfd pfd{fd, POLLIN, 0};
+        for (;;)
+        {
+            int ready = poll(&pfd, 1, timeout);
+            // a signal, such as the SIGWINCH of a terminal resize, doesn't end the batch
+            if (ready < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (ready < 0)
+            {
+                LOGERR("poll on inotify failed: {}", std::strerror(errno));
+            }
+            if (ready == 0)
+            {
+                break;
+            }
+            if (!relevant)
+            {
+                batch.first_event = std::chrono::steady_clock::now();
+            }
+            relevant = ReadEvents(batch) || relevant;
+            // irrelevant events, such as swap files, keep waiting without a timeout
+            timeout = relevant ? debounce_ms : -1;
+        }
+        return batch;
+    }
+
+private:
+    void AddDir(std::string const &dir)
+    {
+        int wd = inotify_add_watch(fd, (ctx.root_dir / dir).string().c_str(),
+            IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO);
+        if (wd < 0)
+        {
+            LOGWARN("failed to watch {}: {}", dir, std::strerror(errno));
+            return;
+        }
+        dirs[wd] = dir;
+    }
+
+    // drain the pending events into batch, true if any of them matters to the build
+    bool ReadEvents(ChangeBatch &batch)
+    {
+        alignas(inotify_event) char buffer[64 * 1024];
+        ssize_t size = read(fd, buffer, sizeof(buffer));
+        bool relevant = false;
+        for (ssize_t pos = 0; pos < size;)
+        {
+            auto const *event = reinterpret_cast<inotify_event const *>(buffer + pos);
+            pos += sizeof(inotify_event) + event->len;
+            auto dir = dirs.find(event->wd);
+            if (dir == dirs.end() || event->len == 0)
+            {
+                continue;
+            }
+            std::string name = event->name;
+            auto relpath = dir->second + "/" + name;
+            if (event->mask & IN_ISDIR)
+            {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    AddTree(relpath);
+                    batch.structural = true;
+                    relevant = true;
+                }
+                continue;
+            }
+            if (!IsWatchedFile(name))
+            {
+                continue;
+            }
+            relevant = true;
+            if (IsSourceName(name) && (event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                                         IN_MOVED_TO)))
+            {
+                batch.structural = true;
+            }
+
+            auto top = dir->second.substr(0, dir->second.find('/'));
+            if (top == ctx.repo_name)
+            {
+                batch.main_target = true;
+            }
+            else if (IsSourceName(name) && dir->second == top)
+            {
+                // add_unit_test and add_benchmark name the targets after their sources, unless
+                // the tests are consolidated into one executable
+                batch.targets.insert(top == "unit_test" && consolidated_tests
+                                         ? "unit_tests"
+                                         : fs::path(name).stem().string());
+            }
+            else
+            {
+                batch.whole_build = true;
+            }
+        }
+        return relevant;
+    }
+
+    WriterContext const &ctx;
+    int fd;
+    std::map<int, std::string> dirs;
+};
+
+void WatchProject()
+{
+    WriterContext ctx;
+    if (!LoadWriterContext(".", ctx))
+    {
+        LOGERR("Operation 'watch' MUST be called under the root of a repo created by cmaker!");
+    }
+    auto build_dir = vm["build-dir"].as<std::string>();
+    if (!fs::exists(fs::path(build_dir) / "CMakeCache.txt"))
+    {
+        LOGERR("{} is not configured, run `cmake -S . -B {}` or `cmake --preset <name>` first",
+            build_dir, build_dir);
+    }
+    auto debounce_ms = static_cast<int>(vm["debounce"].as<unsigned>());
+    ctx.verbose = false;
+
+    Watcher watcher(ctx);
+    std::ifstream cache((fs::path(build_dir) / "CMakeCache.txt").string());
+    std::string line;
+    while (std::getline(cache, line))
+    {
+        if (line == "UNIT_TEST_MODE:STRING=consolidated")
+        {
+            watcher.consolidated_tests = true;
+        }
+    }
+    watcher.AddTree(ctx.repo_name);
+    watcher.AddTree("unit_test");
+    watcher.AddTree("bench");
+    LOGINFO("watching {}/, unit_test/ and bench/, building into {}, Ctrl-C to stop", ctx.repo_name,
+        build_dir);
+    std::fflush(stdout);
+
+    for (;;)
+    {
+        auto batch = watcher.WaitForChanges(debounce_ms);
+        if (batch.Empty())
+        {
+            continue;
+        }
+        if (batch.structural)
+        {
+            RegenSummary summary;
+            GeneratedHashes generated;
+            ctx.regen = &summary;
+            ctx.generated = &generated;
+            WriteSources(ctx);
+            SaveGeneratedHashes(ctx);
+            ctx.regen = nullptr;
+            ctx.generated = nullptr;
+            if (!summary.changed.empty())
+            {
+                LOGINFO("sources.cmake " YELLOW("updated"));
+            }
+        }
+
+        // a changed main target rebuilds its tests and benchmarks as well, they link the library
+        // or the ${PROJECT_NAME}_objects of an executable, a new source may add a target, so
+        // both build everything
+        std::string targets;
+        if (!batch.structural && !batch.whole_build && !batch.main_target)
+        {
+            for (auto const &target : batch.targets)
+            {
+                targets += " " + target;
+            }
+        }
+        LOGINFO("building {}", targets.empty() ? "all" : targets.substr(1));
+        auto command = fmt::format("cmake --build \"{}\"", build_dir);
+        if (!targets.empty())
+        {
+            command += " --target" + targets;
+        }
+        // the build writes to the same terminal, keep the log lines in order
+        std::fflush(stdout);
+        int result = bp::system(command);
+
+        std::chrono::duration<double> latency = std::chrono::steady_clock::now() - batch.first_event;
+        if (result == 0)
+        {
+            LOGINFO(GREEN("build ok") ", edit-to-binary latency {:.2f}s", latency.count());
+        }
+        else
+        {
+            LOGWARN(RED("build failed") ", after {:.2f}s", latency.count());
+        }
+        std::fflush(stdout);
+    }
+}
+#else
+void WatchProject()
+{
+    LOGERR("Operation 'watch' relies on inotify and is only supported on Linux");
+}
+#endif
@@ -1,302 +1,3162 @@
 #include "writer_funcs.h"
 #include <fmt/format.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+
+// the content hashes of the scaffold files as cmaker last wrote them, one "<hash> <path>" per
+// line, so 'cmaker regen' tells a file edited by hand from one which is only out of date
+static const char *generated_hashes_file = ".cmaker-generated";
+
+static std::map<std::string, std::uint64_t> LoadGeneratedHashes(fs::path const &root)
+{
+    std::map<std::string, std::uint64_t> hashes;
+    std::ifstream file((root / generated_hashes_file).string());
+    std::string line;
+    while (std::getline(file, line))
+    {
+        auto space = line.find(' ');
+        if (line.empty() || line[0] == '#' || space == std::string::npos)
+        {
+            continue;
+        }
+        hashes[line.substr(space + 1)] = std::stoull(line.substr(0, space), nullptr, 16);
+    }
+    return hashes;
+}
+
+// an unchanged regen has nothing to merge, so it neither reads nor writes the manifest
+void SaveGeneratedHashes(WriterContext const &ctx)
+{
+    if (!ctx.generated || ctx.generated->written.empty())
+    {
+        return;
+    }
+    auto hashes = LoadGeneratedHashes(ctx.root_dir);
+    for (auto const &entry : ctx.generated->written)
+    {
+        hashes[entry.first] = entry.second;
+    }
+    auto path = ctx.root_dir / generated_hashes_file;
+    std::string text = "# written by cmaker, commit it along with the files it lists\n";
+    for (auto const &entry : hashes)
+    {
+        text += fmt::format("{:016x} {}\n", entry.second, entry.first);
+    }
+    if (!WriteWholeFile(path, text))
+    {
+        LOGERR("failed to write file: {}", path.string());
+    }
+}
+
+// the lines only one of the texts has, the ones of before as "- line", of after as "+ line"
+static std::string LineDiff(std::string const &before, std::string const &after)
+{
+    std::map<std::string, int> counts;
+    std::string line;
+    std::istringstream after_lines(after);
+    while (std::getline(after_lines, line))
+    {
+        ++counts[line];
+    }
+    std::string diff;
+    std::istringstream before_lines(before);
+    while (std::getline(before_lines, line))
+    {
+        if (--counts[line] < 0)
+        {
+            diff += fmt::format("\n    - {}", line);
+        }
+    }
+    after_lines.clear();
+    after_lines.seekg(0);
+    while (std::getline(after_lines, line))
+    {
+        if (counts[line]-- > 0)
+        {
+            diff += fmt::format("\n    + {}", line);
+        }
+    }
+    return diff;
+}
+
+void EmitFile(
+    WriterContext const &ctx, std::string const &relpath, std::string const &content, FileKind kind)
+{
+    auto path = ctx.root_dir / relpath;
+    if (ctx.regen)
+    {
+        if (FileKind::STARTER == kind)
+        {
+            return;
+        }
+        // leave the mtime alone, so cmake and ninja won't see a change
+        if (IsFileContentSame(path, content))
+        {
+            ctx.regen->unchanged.push_back(relpath);
+            return;
+        }
+        // the user's edits win over the templates, files cmaker has no hash of are its own
+        auto hashes = LoadGeneratedHashes(ctx.root_dir);
+        auto generated = hashes.find(relpath);
+        std::ifstream file(path.string(), std::ios::binary);
+        std::string on_disk(
+            (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (!ctx.regen->overwrite_edited && generated != hashes.end() && file.is_open() &&
+            ContentHash(on_disk) != generated->second)
+        {
+            ctx.regen->edited.push_back(relpath);
+            LOGWARN("{} was edited by hand since cmaker wrote it, kept as is, the regenerated one "
+                    "differs in:{}",
+                relpath, LineDiff(on_disk, content));
+            return;
+        }
+        ctx.regen->changed.push_back(relpath);
+    }
+    // such as bench/support/, which repos made by older versions don't have
+    error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    if (!WriteWholeFile(path, content))
+    {
+        LOGERR("failed to write file: {}", path.string());
+    }
+    if (FileKind::SCAFFOLD == kind && ctx.generated)
+    {
+        ctx.generated->written[relpath] = ContentHash(content);
+    }
+}
+
+// cmake_modules/Find<package>.cmake of a heap allocator, laid out like the ones of add-library
+static void WriteAllocatorFindModule(WriterContext const &ctx, std::string const &package,
+    std::string const &library_names, std::string const &header, std::string const &path_suffixes,
+    std::string const &extra)
+{
+    // such as the versioned directories mimalloc installs its files into
+    std::string suffixes =
+        path_suffixes.empty() ? "" : fmt::format("\n  PATH_SUFFIXES {}", path_suffixes);
+    EmitFile(ctx, fmt::format("cmake_modules/Find{}.cmake", package),
+        fmt::format(R"==(# custom Find{0}.cmake generated by CMaker
+
+find_library({1}_LIBRARIES
+  NAMES {2}{5})
+
+find_path({1}_INCLUDE_DIR
+  NAMES {3}{5})
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args({0}
+  DEFAULT_MSG {1}_LIBRARIES {1}_INCLUDE_DIR)
+
+mark_as_advanced(
+  {1}_LIBRARIES
+  {1}_INCLUDE_DIR)
+
+# the program takes no symbol from it by name, operator new reaches malloc through the c++ runtime,
+# so it is linked --no-as-needed, or the linker would drop it
+if({0}_FOUND AND NOT (TARGET {0}::{0}))
+  add_library({0}::{0} INTERFACE IMPORTED)
+  set_target_properties({0}::{0}
+    PROPERTIES
+      INTERFACE_INCLUDE_DIRECTORIES ${{{1}_INCLUDE_DIR}}
+      INTERFACE_LINK_LIBRARIES
+        "$<$<CXX_COMPILER_ID:GNU,Clang>:-Wl,--push-state,--no-as-needed>;${{{1}_LIBRARIES}};$<$<CXX_COMPILER_ID:GNU,Clang>:-Wl,--pop-state>")
+{4}endif()
+)==",
+            package, ToUpper(package), library_names, header, extra, suffixes));
+}
+
+// the modules behind the ALLOCATOR option of the root CMakeLists.txt
+static void WriteAllocatorFindModules(WriterContext const &ctx)
+{
+    WriteAllocatorFindModule(ctx, "Jemalloc", "jemalloc", "jemalloc/jemalloc.h", "", "");
+    WriteAllocatorFindModule(
+        ctx, "Mimalloc", "mimalloc", "mimalloc.h", "mimalloc-2.1 mimalloc-2.0 mimalloc-1.8", "");
+    // gperftools asks gcc not to assume the semantics of the builtin malloc when tcmalloc replaces it
+    WriteAllocatorFindModule(ctx, "Tcmalloc", "tcmalloc_minimal tcmalloc", "gperftools/tcmalloc.h", "",
+        R"(  set_property(TARGET Tcmalloc::Tcmalloc PROPERTY INTERFACE_COMPILE_OPTIONS
+    $<$<CXX_COMPILER_ID:GNU,Clang>:-fno-builtin-malloc;-fno-builtin-calloc;-fno-builtin-realloc;-fno-builtin-free>)
+)");
+}
 
 void WriteCMakeLists(WriterContext const &ctx)
 {
-    auto upper_name = ToUpper(ctx.repo_name);
-    std::ofstream cmakelist("CMakeLists.txt");
-    cmakelist << fmt::format(R"(cmake_minimum_required(VERSION 3.21)
-set({0}_VERSION_MAJOR 0)
-set({0}_VERSION_MINOR 0)
-set({0}_VERSION_PATCH 1)
-project({1} 
-    LANGUAGES
-        CXX C 
-    VERSION
-        ${{{0}_VERSION_MAJOR}}.${{{0}_VERSION_MINOR}}.${{{0}_VERSION_PATCH}})
+    static const Template head(R"(cmake_minimum_required(VERSION 3.21)
+set({{REPO_NAME}}_VERSION_MAJOR 0)
+set({{REPO_NAME}}_VERSION_MINOR 0)
+set({{REPO_NAME}}_VERSION_PATCH 1)
+project({{repo_name}} 
+    LANGUAGES
+        CXX C 
+    VERSION
+        ${{{REPO_NAME}}_VERSION_MAJOR}.${{{REPO_NAME}}_VERSION_MINOR}.${{{REPO_NAME}}_VERSION_PATCH})
+# edit the following settings as you desire
+set(CMAKE_CXX_STANDARD {{cxx_std}})
+set(CMAKE_CXX_STANDARD_REQUIRED ON)
+set(CMAKE_CXX_STANDARD_EXTENSION OFF)
+add_compile_options(-Wfatal-errors)
+
+# edit the following line to add your cmake modules
+list(APPEND CMAKE_MODULE_PATH ${PROJECT_SOURCE_DIR}/cmake_modules)
+# edit the following line to add your dependencies
+find_package(Threads REQUIRED)
+
+)");
+    // compiler launcher, the base dir and prefix map keep absolute paths out of the cache keys
+    static const Template compiler_cache(R"(# compiler cache launcher, auto picks ccache or sccache when either one is installed
+set(COMPILER_CACHE "auto" CACHE STRING "compiler cache launcher: auto, ccache, sccache or none")
+set_property(CACHE COMPILER_CACHE PROPERTY STRINGS auto ccache sccache none)
+if(NOT COMPILER_CACHE STREQUAL "none")
+    if(COMPILER_CACHE STREQUAL "auto")
+        find_program(COMPILER_CACHE_PROGRAM NAMES ccache sccache NO_CACHE)
+    else()
+        find_program(COMPILER_CACHE_PROGRAM NAMES ${COMPILER_CACHE} NO_CACHE)
+    endif()
+    if(COMPILER_CACHE_PROGRAM)
+        message(STATUS "compiler cache: ${COMPILER_CACHE_PROGRAM}")
+        set(COMPILER_CACHE_LAUNCHER ${COMPILER_CACHE_PROGRAM})
+        if(COMPILER_CACHE_PROGRAM MATCHES "ccache$")
+            # hash the paths relative to the source dir, so every checkout and build dir shares hits
+            set(COMPILER_CACHE_LAUNCHER ${CMAKE_COMMAND} -E env
+                CCACHE_BASEDIR=${PROJECT_SOURCE_DIR} CCACHE_NOHASHDIR=true ${COMPILER_CACHE_PROGRAM})
+        endif()
+        set(CMAKE_C_COMPILER_LAUNCHER ${COMPILER_CACHE_LAUNCHER})
+        set(CMAKE_CXX_COMPILER_LAUNCHER ${COMPILER_CACHE_LAUNCHER})
+        # no absolute source path leaks into __FILE__ or debug info
+        include(CheckCXXCompilerFlag)
+        check_cxx_compiler_flag("-ffile-prefix-map=${PROJECT_SOURCE_DIR}=." HAS_FILE_PREFIX_MAP)
+        if(HAS_FILE_PREFIX_MAP)
+            add_compile_options("-ffile-prefix-map=${PROJECT_SOURCE_DIR}=.")
+        endif()
+    elseif(COMPILER_CACHE STREQUAL "auto")
+        message(STATUS "no compiler cache found, install ccache or sccache to speed up rebuilds")
+    else()
+        message(WARNING "COMPILER_CACHE=${COMPILER_CACHE} but ${COMPILER_CACHE} is not found")
+    endif()
+endif()
+
+)");
+    // linker, set before any target is created so the main target, tests and benches all use it
+    static const Template fast_linker(R"(# linker, auto picks the first of mold, lld and gold which the compiler driver accepts
+set(FAST_LINKER "{{linker}}" CACHE STRING "linker: auto, mold, lld, gold or default")
+set_property(CACHE FAST_LINKER PROPERTY STRINGS auto mold lld gold default)
+if(NOT FAST_LINKER STREQUAL "default")
+    include(CheckLinkerFlag)
+    if(FAST_LINKER STREQUAL "auto" AND CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+        # lld does not load the GCC LTO plugin, so gold goes first for GCC
+        set(FAST_LINKER_CANDIDATES mold gold lld)
+    elseif(FAST_LINKER STREQUAL "auto")
+        set(FAST_LINKER_CANDIDATES mold lld gold)
+    else()
+        set(FAST_LINKER_CANDIDATES ${FAST_LINKER})
+    endif()
+    unset(FAST_LINKER_FOUND)
+    foreach(FAST_LINKER_CANDIDATE IN LISTS FAST_LINKER_CANDIDATES)
+        string(TOUPPER ${FAST_LINKER_CANDIDATE} FAST_LINKER_TYPE)
+        check_linker_flag(CXX "-fuse-ld=${FAST_LINKER_CANDIDATE}" HAS_LINKER_${FAST_LINKER_TYPE})
+        if(HAS_LINKER_${FAST_LINKER_TYPE})
+            set(FAST_LINKER_FOUND ${FAST_LINKER_CANDIDATE})
+            break()
+        endif()
+    endforeach()
+    if(FAST_LINKER_FOUND)
+        message(STATUS "linker: ${FAST_LINKER_FOUND}")
+        if(CMAKE_VERSION VERSION_GREATER_EQUAL 3.29)
+            string(TOUPPER ${FAST_LINKER_FOUND} CMAKE_LINKER_TYPE)
+        else()
+            add_link_options(-fuse-ld=${FAST_LINKER_FOUND})
+        endif()
+        # mold runs on every core by default, lld and gold are told how many threads to use
+        cmake_host_system_information(RESULT LINKER_THREADS QUERY NUMBER_OF_LOGICAL_CORES)
+        if(FAST_LINKER_FOUND STREQUAL "lld")
+            set(LINKER_THREAD_FLAGS "LINKER:--threads=${LINKER_THREADS}")
+        elseif(FAST_LINKER_FOUND STREQUAL "gold")
+            set(LINKER_THREAD_FLAGS "LINKER:--threads,--thread-count=${LINKER_THREADS}")
+        endif()
+        if(LINKER_THREAD_FLAGS)
+            check_linker_flag(CXX "-fuse-ld=${FAST_LINKER_FOUND};${LINKER_THREAD_FLAGS}"
+                HAS_LINKER_THREADS_${FAST_LINKER_TYPE})
+            if(HAS_LINKER_THREADS_${FAST_LINKER_TYPE})
+                add_link_options(${LINKER_THREAD_FLAGS})
+            endif()
+        endif()
+    elseif(FAST_LINKER STREQUAL "auto")
+        message(STATUS "no faster linker found, install mold or lld to speed up the links")
+    else()
+        message(WARNING "FAST_LINKER=${FAST_LINKER} but -fuse-ld=${FAST_LINKER} is not supported")
+    endif()
+endif()
+
+)");
+    // instruction set, an interface target the objects link, so the main target, tests and benches
+    // all use it, while the runtime dispatched code of simd/ keeps its own levels
+    static const Template target_isa(R"(# instruction set of the main target, the unit tests and the benchmarks: baseline runs on any
+# x86-64 host, x86-64-v2 adds SSE4.2 and POPCNT, x86-64-v3 AVX2, FMA and BMI2, x86-64-v4 AVX-512,
+# and native whatever the build host has. A binary built for a higher level crashes on the older
+# hosts, so GetVersionString() reports it. The objects link ${PROJECT_NAME}_target_isa for the
+# flag, the SIMD kernels of simd/ set their own levels
+set(TARGET_ISA "{{target_isa}}" CACHE STRING "instruction set: baseline, x86-64-v2, x86-64-v3, x86-64-v4 or native")
+set_property(CACHE TARGET_ISA PROPERTY STRINGS baseline x86-64-v2 x86-64-v3 x86-64-v4 native)
+add_library(${PROJECT_NAME}_target_isa INTERFACE)
+if(NOT TARGET_ISA STREQUAL "baseline")
+    if(MSVC)
+        set(TARGET_ISA_FLAG_x86-64-v3 /arch:AVX2)
+        set(TARGET_ISA_FLAG_x86-64-v4 /arch:AVX512)
+        set(TARGET_ISA_FLAG "${TARGET_ISA_FLAG_${TARGET_ISA}}")
+    else()
+        set(TARGET_ISA_FLAG -march=${TARGET_ISA})
+    endif()
+    if(TARGET_ISA_FLAG)
+        include(CheckCXXCompilerFlag)
+        string(MAKE_C_IDENTIFIER "CXX_HAS_TARGET_ISA_${TARGET_ISA}" TARGET_ISA_SUPPORTED)
+        check_cxx_compiler_flag(${TARGET_ISA_FLAG} ${TARGET_ISA_SUPPORTED})
+    endif()
+    if(TARGET_ISA_FLAG AND ${TARGET_ISA_SUPPORTED})
+        target_compile_options(${PROJECT_NAME}_target_isa INTERFACE ${TARGET_ISA_FLAG})
+        message(STATUS "target ISA: ${TARGET_ISA}")
+    else()
+        message(WARNING "TARGET_ISA=${TARGET_ISA} is not supported by the compiler, building for the baseline")
+        set(TARGET_ISA baseline)
+    endif()
+endif()
+target_compile_definitions(${PROJECT_NAME}_target_isa INTERFACE {{REPO_NAME}}_TARGET_ISA="${TARGET_ISA}")
+
+)");
+    // profile-guided optimization trained by the benchmarks, see the pgo-train target in bench/
+    static const Template profile_guided_optimization(R"(# profile-guided optimization in 3 steps, all in the same build dir:
+# 1. configure with -DPGO=generate -DBUILD_BENCHMARKS=ON and build
+# 2. `cmake --build <build dir> --target pgo-train` runs every benchmark to collect the profiles
+# 3. reconfigure with -DPGO=use and build again, clang profiles are merged by llvm-profdata
+set(PGO "off" CACHE STRING "profile-guided optimization: off, generate or use")
+set_property(CACHE PGO PROPERTY STRINGS off generate use)
+set(PGO_PROFILE_DIR ${CMAKE_BINARY_DIR}/pgo-profiles CACHE PATH "directory of the PGO profiles")
+if(PGO STREQUAL "generate")
+    if(NOT BUILD_BENCHMARKS)
+        message(WARNING "PGO=generate trains on the benchmarks, configure with -DBUILD_BENCHMARKS=ON to get the pgo-train target")
+    endif()
+    file(MAKE_DIRECTORY ${PGO_PROFILE_DIR})
+    add_compile_options(-fprofile-generate=${PGO_PROFILE_DIR})
+    add_link_options(-fprofile-generate=${PGO_PROFILE_DIR})
+    if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+        # the counters of multi-threaded benchmarks stay consistent
+        add_compile_options(-fprofile-update=atomic)
+    endif()
+elseif(PGO STREQUAL "use")
+    if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        get_filename_component(CXX_COMPILER_DIR ${CMAKE_CXX_COMPILER} DIRECTORY)
+        find_program(LLVM_PROFDATA NAMES llvm-profdata HINTS ${CXX_COMPILER_DIR})
+        file(GLOB PGO_RAW_PROFILES ${PGO_PROFILE_DIR}/*.profraw)
+        if(NOT LLVM_PROFDATA)
+            message(FATAL_ERROR "PGO=use with clang requires llvm-profdata")
+        elseif(NOT PGO_RAW_PROFILES)
+            message(FATAL_ERROR "no profile in ${PGO_PROFILE_DIR}, build with -DPGO=generate and run pgo-train first")
+        endif()
+        set(PGO_MERGED_PROFILE ${PGO_PROFILE_DIR}/merged.profdata)
+        execute_process(
+            COMMAND ${LLVM_PROFDATA} merge -output=${PGO_MERGED_PROFILE} ${PGO_RAW_PROFILES}
+            RESULT_VARIABLE PGO_MERGE_RESULT)
+        if(NOT PGO_MERGE_RESULT EQUAL 0)
+            message(FATAL_ERROR "llvm-profdata failed to merge the profiles in ${PGO_PROFILE_DIR}")
+        endif()
+        add_compile_options(-fprofile-use=${PGO_MERGED_PROFILE}
+            -Wno-profile-instr-unprofiled -Wno-profile-instr-out-of-date)
+        add_link_options(-fprofile-use=${PGO_MERGED_PROFILE})
+    else()
+        file(GLOB_RECURSE PGO_GCC_PROFILES ${PGO_PROFILE_DIR}/*.gcda)
+        if(NOT PGO_GCC_PROFILES)
+            message(WARNING "no profile in ${PGO_PROFILE_DIR}, build with -DPGO=generate and run pgo-train first")
+        endif()
+        add_compile_options(-fprofile-use=${PGO_PROFILE_DIR} -Wno-missing-profile)
+        add_link_options(-fprofile-use=${PGO_PROFILE_DIR})
+        # code never run by the benchmarks keeps being optimized as usual instead of for size
+        include(CheckCXXCompilerFlag)
+        check_cxx_compiler_flag(-fprofile-partial-training HAS_PROFILE_PARTIAL_TRAINING)
+        if(HAS_PROFILE_PARTIAL_TRAINING)
+            add_compile_options(-fprofile-partial-training)
+        endif()
+    endif()
+endif()
+
+)");
+    static const Template source_lists(R"(# the source lists are written by cmaker instead of globbed at every configure,
+# run 'cmaker sync' after adding, removing or renaming a source file
+include(${PROJECT_SOURCE_DIR}/sources.cmake)
+)");
+    // for executable repo, EXECUTABLE_SRC lists the cpp files under the 'repo_name' dir, all but
+    // main.cpp go to the object library, so the tests and benchmarks don't get a second main()
+    static const Template executable_target(R"(# the sources are compiled once into ${PROJECT_NAME}_objects, which the executable, the unit tests
+# and the benchmarks all link
+set(EXECUTABLE_MAIN ${PROJECT_SOURCE_DIR}/{{repo_name}}/main.cpp)
+list(REMOVE_ITEM EXECUTABLE_SRC ${EXECUTABLE_MAIN})
+add_library(${PROJECT_NAME}_objects OBJECT ${EXECUTABLE_SRC})
+# you may add more dependencies' header dir here
+target_include_directories(${PROJECT_NAME}_objects PUBLIC
+    ${PROJECT_SOURCE_DIR}/{{repo_name}})
+target_link_libraries(${PROJECT_NAME}_objects PUBLIC ${PROJECT_NAME}_target_isa)
+add_executable(${PROJECT_NAME} ${EXECUTABLE_MAIN})
+target_link_libraries(${PROJECT_NAME} PRIVATE ${PROJECT_NAME}_objects)
+set(LIBRARIES_FOR_TEST ${PROJECT_NAME}_objects)
+
+)");
+    // for library repo, LIBRARY_SRC lists the cpp files under the 'repo_name' dir
+    static const Template library_target(R"(# the sources are compiled once into ${PROJECT_NAME}_objects, which the library, the unit tests
+# and the benchmarks all link
+add_library(${PROJECT_NAME}_objects OBJECT ${LIBRARY_SRC})
+# you may add more dependencies' header dir here
+target_include_directories(${PROJECT_NAME}_objects
+    PUBLIC
+        ${PROJECT_SOURCE_DIR}/{{repo_name}}
+    PRIVATE
+        ${PROJECT_SOURCE_DIR}/src)
+target_link_libraries(${PROJECT_NAME}_objects PUBLIC ${PROJECT_NAME}_target_isa)
+add_library(${PROJECT_NAME} {{library_type}})
+# the objects are an implementation detail, installed users only see the library
+target_link_libraries(${PROJECT_NAME} PRIVATE $<BUILD_INTERFACE:${PROJECT_NAME}_objects>)
+target_include_directories(${PROJECT_NAME}
+    PUBLIC
+        $<BUILD_INTERFACE:${PROJECT_SOURCE_DIR}/{{repo_name}}>
+        $<INSTALL_INTERFACE:{{repo_name}}>)
+set(LIBRARIES_FOR_TEST ${PROJECT_NAME}_objects)
+
+)");
+    // the objects of a shared library end up in a .so
+    static const Template shared_objects(R"(set_target_properties(${PROJECT_NAME}_objects PROPERTIES POSITION_INDEPENDENT_CODE ON)
+
+)");
+    // unity build, the sources listed in UNITY_BUILD_EXCLUDE_SRCS are compiled on their own
+    static const Template unity_build(R"(# unity build merges the sources into batches to save the repeated header parsing,
+# add the sources that break in a unity batch (static symbol clashes, etc.) to UNITY_BUILD_EXCLUDE_SRCS
+option(ENABLE_UNITY_BUILD "build ${PROJECT_NAME}_objects in unity batches" ON)
+set(UNITY_BUILD_BATCH_SIZE {{unity_batch_size}} CACHE STRING "number of sources merged into one unity batch")
+set(UNITY_BUILD_EXCLUDE_SRCS
+    # ${PROJECT_SOURCE_DIR}/{{repo_name}}/compiled_alone.cpp
+    )
+if(ENABLE_UNITY_BUILD)
+    set_target_properties(${PROJECT_NAME}_objects PROPERTIES
+        UNITY_BUILD ON
+        UNITY_BUILD_BATCH_SIZE ${UNITY_BUILD_BATCH_SIZE})
+    if(UNITY_BUILD_EXCLUDE_SRCS)
+        set_source_files_properties(${UNITY_BUILD_EXCLUDE_SRCS}
+            PROPERTIES SKIP_UNITY_BUILD_INCLUSION ON)
+    endif()
+endif()
+
+)");
+    // precompiled headers, shared with unit_test and bench through PROJECT_PCH_HEADERS
+    static const Template precompiled_headers(R"(# precompiled headers, run `cmaker pch suggest` to list the most included system headers of the repo
+option(ENABLE_PCH "precompile the commonly used headers" ON)
+set(PROJECT_PCH_HEADERS
+    <algorithm>
+    <memory>
+    <string>
+    <vector>
+    )
+if(ENABLE_PCH)
+    target_precompile_headers(${PROJECT_NAME}_objects PRIVATE ${PROJECT_PCH_HEADERS})
+endif()
+
+)");
+    // link-time optimization of the optimized configs, links run in a pool sized by the free RAM
+    static const Template link_time_optimization(R"(# link-time optimization of the Release, RelWithDebInfo and MinSizeRel configs
+set(LTO_MODE "{{lto_mode}}" CACHE STRING "link-time optimization: off, full or thin")
+set_property(CACHE LTO_MODE PROPERTY STRINGS off full thin)
+if(NOT LTO_MODE STREQUAL "off")
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT IPO_SUPPORTED OUTPUT IPO_ERROR LANGUAGES CXX)
+    if(IPO_SUPPORTED)
+        set_target_properties(${PROJECT_NAME} ${PROJECT_NAME}_objects PROPERTIES
+            INTERPROCEDURAL_OPTIMIZATION_RELEASE ON
+            INTERPROCEDURAL_OPTIMIZATION_RELWITHDEBINFO ON
+            INTERPROCEDURAL_OPTIMIZATION_MINSIZEREL ON)
+        # the unit tests and benchmarks link the LTO objects, so they are LTO linked as well
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION_RELEASE ON)
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION_RELWITHDEBINFO ON)
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION_MINSIZEREL ON)
+        if(LTO_MODE STREQUAL "thin" AND CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+            # cmake asks for full LTO, switch clang over to ThinLTO
+            set(LTO_THIN_FLAG $<$<CONFIG:Release,RelWithDebInfo,MinSizeRel>:-flto=thin>)
+            target_compile_options(${PROJECT_NAME}_objects PRIVATE ${LTO_THIN_FLAG})
+            target_link_options(${PROJECT_NAME} PRIVATE ${LTO_THIN_FLAG})
+            add_link_options(${LTO_THIN_FLAG})
+        elseif(LTO_MODE STREQUAL "thin")
+            message(STATUS "ThinLTO is clang only, ${CMAKE_CXX_COMPILER_ID} runs its own parallel LTO")
+        endif()
+    else()
+        message(WARNING "LTO_MODE=${LTO_MODE} but LTO is not supported: ${IPO_ERROR}")
+    endif()
+
+    # every LTO link may take gigabytes, the ninja link pool runs as many links as the RAM can hold
+    set(LTO_LINK_MEMORY_MB 4096 CACHE STRING "estimated peak memory of one LTO link in MiB")
+    cmake_host_system_information(RESULT AVAILABLE_MEMORY_MB QUERY AVAILABLE_PHYSICAL_MEMORY)
+    math(EXPR LTO_LINK_JOBS "${AVAILABLE_MEMORY_MB} / ${LTO_LINK_MEMORY_MB}")
+    if(LTO_LINK_JOBS LESS 1)
+        set(LTO_LINK_JOBS 1)
+    endif()
+    message(STATUS "LTO link pool: ${LTO_LINK_JOBS} job(s) for ${AVAILABLE_MEMORY_MB} MiB available memory")
+    set_property(GLOBAL APPEND PROPERTY JOB_POOLS lto_link_pool=${LTO_LINK_JOBS})
+    set_target_properties(${PROJECT_NAME} PROPERTIES JOB_POOL_LINK lto_link_pool)
+    # unit tests and benchmarks are LTO links as well
+    set(CMAKE_JOB_POOL_LINK lto_link_pool)
+endif()
+
+)");
+    // post-link code layout optimization, executable repo only
+    static const Template bolt(R"(# post-link optimization with BOLT, -DENABLE_BOLT=ON adds a `bolt` target which profiles
+# BOLT_TRAINING_COMMAND under perf, then writes the layout-optimized ${PROJECT_NAME}.bolt next to ${PROJECT_NAME}
+option(ENABLE_BOLT "add the bolt target to optimize the code layout of ${PROJECT_NAME}" OFF)
+if(ENABLE_BOLT)
+    find_program(PERF_PROGRAM perf)
+    find_program(PERF2BOLT_PROGRAM perf2bolt)
+    find_program(LLVM_BOLT_PROGRAM llvm-bolt)
+    if(PERF_PROGRAM AND PERF2BOLT_PROGRAM AND LLVM_BOLT_PROGRAM)
+        # BOLT needs the relocations to move the functions around
+        target_link_options(${PROJECT_NAME} PRIVATE -Wl,--emit-relocs)
+        set(BOLT_TRAINING_COMMAND "$<TARGET_FILE:${PROJECT_NAME}>" CACHE STRING
+            "representative workload of ${PROJECT_NAME} run under perf to collect the BOLT profile")
+        option(BOLT_USE_LBR "sample with the last branch records, turn it off on hosts without LBR" ON)
+        separate_arguments(BOLT_TRAINING_ARGS UNIX_COMMAND "${BOLT_TRAINING_COMMAND}")
+        set(BOLT_DIR ${CMAKE_CURRENT_BINARY_DIR}/bolt)
+        if(BOLT_USE_LBR)
+            set(BOLT_RECORD_ARGS -e cycles:u -j any,u)
+            set(BOLT_CONVERT_ARGS)
+        else()
+            set(BOLT_RECORD_ARGS -e cycles:u)
+            set(BOLT_CONVERT_ARGS -nl)
+        endif()
+        add_custom_target(bolt
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${BOLT_DIR}
+            COMMAND ${PERF_PROGRAM} record ${BOLT_RECORD_ARGS} -o ${BOLT_DIR}/perf.data -- ${BOLT_TRAINING_ARGS}
+            COMMAND ${PERF2BOLT_PROGRAM} ${BOLT_CONVERT_ARGS} -p ${BOLT_DIR}/perf.data
+                -o ${BOLT_DIR}/perf.fdata $<TARGET_FILE:${PROJECT_NAME}>
+            COMMAND ${LLVM_BOLT_PROGRAM} $<TARGET_FILE:${PROJECT_NAME}> -o $<TARGET_FILE:${PROJECT_NAME}>.bolt
+                -data=${BOLT_DIR}/perf.fdata -reorder-blocks=ext-tsp -reorder-functions=hfsort
+                -split-functions -split-all-cold -split-eh -dyno-stats
+            DEPENDS ${PROJECT_NAME}
+            COMMENT "optimizing the code layout of ${PROJECT_NAME} with BOLT"
+            VERBATIM)
+    else()
+        message(WARNING "ENABLE_BOLT requires perf, perf2bolt and llvm-bolt, the bolt target is skipped")
+    endif()
+endif()
+
+)");
+    // heap allocator, one of the dependencies, so the main target, tests and benches all use it
+    static const Template heap_allocator(R"(# heap allocator, jemalloc, mimalloc and tcmalloc are found by the Find modules of cmake_modules,
+# bench/allocator compares the ones installed on the host
+set(ALLOCATOR "{{allocator}}" CACHE STRING "heap allocator: system, jemalloc, mimalloc or tcmalloc")
+set_property(CACHE ALLOCATOR PROPERTY STRINGS system jemalloc mimalloc tcmalloc)
+if(ALLOCATOR MATCHES "^(jemalloc|mimalloc|tcmalloc)$")
+    # jemalloc is found by FindJemalloc.cmake as Jemalloc::Jemalloc
+    string(SUBSTRING ${ALLOCATOR} 0 1 ALLOCATOR_HEAD)
+    string(SUBSTRING ${ALLOCATOR} 1 -1 ALLOCATOR_TAIL)
+    string(TOUPPER ${ALLOCATOR_HEAD} ALLOCATOR_HEAD)
+    set(ALLOCATOR_PACKAGE ${ALLOCATOR_HEAD}${ALLOCATOR_TAIL})
+    find_package(${ALLOCATOR_PACKAGE} REQUIRED)
+    list(APPEND PROJECT_DEPENDENCIES ${ALLOCATOR_PACKAGE}::${ALLOCATOR_PACKAGE})
+    message(STATUS "allocator: ${ALLOCATOR}")
+elseif(NOT ALLOCATOR STREQUAL "system")
+    message(FATAL_ERROR "unknown ALLOCATOR ${ALLOCATOR}, expects system, jemalloc, mimalloc or tcmalloc")
+endif()
+
+)");
+    // runtime dispatched kernels of 'cmaker template simd'
+    static const Template simd_kernels(R"(# the SIMD kernels of `cmaker template simd`, one object library per ISA level plus the dispatcher,
+# linked straight into the main target, the unit tests and the benchmarks, since the object files
+# of an object library don't pass through the targets linking it
+if(EXISTS ${PROJECT_SOURCE_DIR}/simd/CMakeLists.txt)
+    add_subdirectory(simd)
+    target_link_libraries(${PROJECT_NAME}_objects PUBLIC simd_dispatch)
+    foreach(SIMD_OBJECT_LIBRARY ${SIMD_OBJECT_LIBRARIES})
+        target_link_libraries(${PROJECT_NAME} PRIVATE $<BUILD_INTERFACE:${SIMD_OBJECT_LIBRARY}>)
+    endforeach()
+    list(APPEND LIBRARIES_FOR_TEST ${SIMD_OBJECT_LIBRARIES})
+endif()
+
+)");
+    // link example
+    static const Template dependencies(R"(# edit the following line to link your dependencies libraries, they reach the main target, the
+# unit tests and the benchmarks through the objects
+list(APPEND PROJECT_DEPENDENCIES
+        Threads::Threads)
+target_link_libraries(${PROJECT_NAME}_objects PUBLIC ${PROJECT_DEPENDENCIES})
+)");
+    // the objects are linked through $<BUILD_INTERFACE>, which leaves them out of the installed
+    // link interface of the library
+    static const Template library_dependencies(R"(# the objects are left out of the installed library, which names the dependencies itself, so the
+# users of a static library link them as well
+target_link_libraries(${PROJECT_NAME} PRIVATE ${PROJECT_DEPENDENCIES})
+)");
+    // unit tests, benchmarks and install
+    static const Template install(R"(
+# unit tests and benchmarks
+option(BUILD_TESTS "build unit tests" OFF)
+if(BUILD_TESTS AND EXISTS ${PROJECT_SOURCE_DIR}/unit_test/CMakeLists.txt)
+    find_package(GTest REQUIRED)
+    enable_testing()
+    add_subdirectory(unit_test)
+endif()
+option(BUILD_BENCHMARKS "build benchmark tests" OFF)
+if(BUILD_BENCHMARKS AND EXISTS ${PROJECT_SOURCE_DIR}/bench/CMakeLists.txt)
+    find_package(benchmark REQUIRED)
+    # for the instruction count checks of the benchmarks
+    enable_testing()
+    add_subdirectory(bench)
+endif()
+
+# install settings
+include(GNUInstallDirs)
+install(TARGETS ${PROJECT_NAME}
+    EXPORT {{REPO_NAME}}_EXPORT
+    RUNTIME DESTINATION ${CMAKE_INSTALL_BINDIR}
+    LIBRARY DESTINATION ${CMAKE_INSTALL_LIBDIR}
+    ARCHIVE DESTINATION ${CMAKE_INSTALL_LIBDIR})
+)");
+    // install public headers if it's library repo
+    static const Template install_headers(R"(# install public headers
+set(PUBLIC_HEADER_DIR ${PROJECT_SOURCE_DIR}/{{repo_name}})
+install(DIRECTORY ${PUBLIC_HEADER_DIR}
+    DESTINATION ${CMAKE_INSTALL_INCLUDEDIR}
+    FILES_MATCHING
+        PATTERN "*.h"
+        PATTERN "*.hpp")
+)");
+    // export cmake config, versioning for both library and executable repo, and cpack settings
+    static const Template package(R"(install(EXPORT {{REPO_NAME}}_EXPORT
+    FILE {{repo_name}}-config.cmake
+    NAMESPACE {{repo_name}}::
+    DESTINATION cmake)
+    include(CMakePackageConfigHelpers)
+write_basic_package_version_file(
+    "{{repo_name}}-config-version.cmake"
+    COMPATIBILITY SameMajorVersion)
+install(FILES
+    "${CMAKE_CURRENT_BINARY_DIR}/{{repo_name}}-config-version.cmake"
+    DESTINATION cmake)
+message(STATUS "current {{repo_name}} version: ${{{REPO_NAME}}_VERSION_MAJOR}.${{{REPO_NAME}}_VERSION_MINOR}.${{{REPO_NAME}}_VERSION_PATCH}")
+set(CPACK_PACKAGE_VERSION_MAJOR ${{{REPO_NAME}}_VERSION_MAJOR})
+set(CPACK_PACKAGE_VERSION_MINOR ${{{REPO_NAME}}_VERSION_MINOR})
+set(CPACK_PACKAGE_VERSION_PATCH ${{{REPO_NAME}}_VERSION_PATCH})
+# cpack settings, edit the following to pack up as you desire
+if(UNIX)
+    set(CPACK_GENERATOR "TGZ")
+else()
+    set(CPACK_GENERATOR "ZIP")
+endif()
+set(CPACK_PACKAGE_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}/packages)
+include(CPack)
+)");
+
+    std::string cmakelist;
+    head.RenderTo(cmakelist, ctx);
+    compiler_cache.RenderTo(cmakelist, ctx);
+    fast_linker.RenderTo(cmakelist, ctx);
+    target_isa.RenderTo(cmakelist, ctx);
+    profile_guided_optimization.RenderTo(cmakelist, ctx);
+    source_lists.RenderTo(cmakelist, ctx);
+    if (RepoType::EXECUTABLE == ctx.repo_type)
+    {
+        executable_target.RenderTo(cmakelist, ctx);
+    }
+    else
+    {
+        library_target.RenderTo(cmakelist, ctx);
+    }
+    if (RepoType::SHARED == ctx.repo_type)
+    {
+        shared_objects.RenderTo(cmakelist, ctx);
+    }
+    if (ctx.unity_batch_size > 0)
+    {
+        unity_build.RenderTo(cmakelist, ctx);
+    }
+    if (ctx.pch)
+    {
+        precompiled_headers.RenderTo(cmakelist, ctx);
+    }
+    if (ctx.lto_mode != "off")
+    {
+        link_time_optimization.RenderTo(cmakelist, ctx);
+    }
+    if (RepoType::EXECUTABLE == ctx.repo_type)
+    {
+        bolt.RenderTo(cmakelist, ctx);
+    }
+    heap_allocator.RenderTo(cmakelist, ctx);
+    simd_kernels.RenderTo(cmakelist, ctx);
+    dependencies.RenderTo(cmakelist, ctx);
+    if (RepoType::EXECUTABLE != ctx.repo_type)
+    {
+        library_dependencies.RenderTo(cmakelist, ctx);
+    }
+    install.RenderTo(cmakelist, ctx);
+    if (RepoType::EXECUTABLE != ctx.repo_type)
+    {
+        install_headers.RenderTo(cmakelist, ctx);
+    }
+    package.RenderTo(cmakelist, ctx);
+
+    EmitFile(ctx, "CMakeLists.txt", cmakelist);
+    WriteAllocatorFindModules(ctx);
+    if (ctx.verbose)
+        LOGINFO("root CMakeLists.txt written complete!");
+}
+
+void WriteUnitTests(WriterContext const &ctx)
+{
+    EmitFile(ctx, "unit_test/CMakeLists.txt", R"(# with ENABLE_PCH every test reuses the precompiled headers of unit_test_pch,
+# so gtest is parsed once instead of once per test executable
+if(ENABLE_PCH)
+    file(CONFIGURE OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/unit_test_pch.cpp CONTENT "")
+    add_library(unit_test_pch OBJECT ${CMAKE_CURRENT_BINARY_DIR}/unit_test_pch.cpp)
+    # the same instruction set as the tests reusing it
+    target_link_libraries(unit_test_pch PRIVATE GTest::gtest Threads::Threads ${PROJECT_NAME}_target_isa)
+    target_precompile_headers(unit_test_pch PRIVATE <gtest/gtest.h> ${PROJECT_PCH_HEADERS})
+endif()
+
+include(GoogleTest)
+
+# an easy way to add unit test
+#     add_unit_test(CASE_TARGET SOURCE... [PROCESSORS <n>] [RESOURCE_LOCK <name>])
+# every TEST() of the target becomes its own ctest entry, so `ctest -j` spreads them over the cores
+#     PROCESSORS     cores taken by each test of the target, ctest -j won't oversubscribe them
+#     RESOURCE_LOCK  a resource the tests can't share with other tests, such as a port or a file
+function(add_unit_test CASE_TARGET)
+    cmake_parse_arguments(ARG "" "PROCESSORS;RESOURCE_LOCK" "" ${ARGN})
+    add_executable(${CASE_TARGET} ${ARG_UNPARSED_ARGUMENTS})
+    target_link_libraries(${CASE_TARGET}
+        PRIVATE 
+            ${LIBRARIES_FOR_TEST} # the objects of the repo, see the root CMakeLists.txt
+            GTest::gtest
+            GTest::gtest_main
+            Threads::Threads)
+    if(ENABLE_PCH)
+        target_precompile_headers(${CASE_TARGET} REUSE_FROM unit_test_pch)
+    endif()
+    set(CASE_PROPERTIES)
+    if(ARG_PROCESSORS)
+        list(APPEND CASE_PROPERTIES PROCESSORS ${ARG_PROCESSORS})
+    endif()
+    if(ARG_RESOURCE_LOCK)
+        list(APPEND CASE_PROPERTIES RESOURCE_LOCK ${ARG_RESOURCE_LOCK})
+    endif()
+    # the tests are listed when ctest runs instead of after every link
+    gtest_discover_tests(${CASE_TARGET}
+        TEST_PREFIX "${CASE_TARGET}."
+        DISCOVERY_MODE PRE_TEST
+        PROPERTIES ${CASE_PROPERTIES})
+endfunction()
+
+# per-file links one executable for every test source, consolidated links all of them into the
+# single unit_tests executable, which saves a link of the whole library per test source.
+# both register every TEST() as its own ctest entry
+set(UNIT_TEST_MODE "per-file" CACHE STRING "unit test executables: per-file or consolidated")
+set_property(CACHE UNIT_TEST_MODE PROPERTY STRINGS per-file consolidated)
+
+# UNIT_TEST_SRCS is listed in sources.cmake of the repo root, run 'cmaker sync' after adding a test
+if(UNIT_TEST_MODE STREQUAL "consolidated")
+    add_unit_test(unit_tests ${UNIT_TEST_SRCS})
+elseif(UNIT_TEST_MODE STREQUAL "per-file")
+    foreach(TEST_SRC ${UNIT_TEST_SRCS})
+        get_filename_component(BASE_NAME ${TEST_SRC} NAME_WE)
+        add_unit_test(${BASE_NAME} ${TEST_SRC})
+    endforeach()
+else()
+    message(FATAL_ERROR "UNIT_TEST_MODE=${UNIT_TEST_MODE}, expects per-file or consolidated")
+endif()
+)");
+
+    EmitFile(ctx, "unit_test/example.cpp", R"(#include <gtest/gtest.h>
+TEST(EXAMPLE, example_case)
+{
+    int i = 1;
+    EXPECT_EQ(i, 1);
+    bool no = false;
+    EXPECT_FALSE(no);
+}
+)",
+        FileKind::STARTER);
+
+    if (ctx.verbose)
+        LOGINFO("unit_test/CMakeLists.txt written complete!");
+}
+
+void WriteBenchmark(WriterContext const &ctx)
+{
+    EmitFile(ctx, "bench/CMakeLists.txt", R"(# with ENABLE_PCH every benchmark reuses the precompiled headers of bench_pch
+if(ENABLE_PCH)
+    file(CONFIGURE OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/bench_pch.cpp CONTENT "")
+    add_library(bench_pch OBJECT ${CMAKE_CURRENT_BINARY_DIR}/bench_pch.cpp)
+    # the same instruction set as the benchmarks reusing it
+    target_link_libraries(bench_pch PRIVATE benchmark Threads::Threads ${PROJECT_NAME}_target_isa)
+    target_precompile_headers(bench_pch PRIVATE <benchmark/benchmark.h> ${PROJECT_PCH_HEADERS})
+endif()
+
+# the hardware counters come from libpfm, Google Benchmark has to be built with
+# -DBENCHMARK_ENABLE_LIBPFM=ON to read them, run-benchmarks derives IPC and the misses per
+# thousand instructions (MPKI) from them
+option(BENCH_PERF_COUNTERS "count cycles, instructions, cache and branch misses of every benchmark" OFF)
+set(BENCH_PERF_COUNTER_EVENTS "CYCLES,INSTRUCTIONS,CACHE-MISSES,BRANCH-MISSES" CACHE STRING
+    "libpfm events counted by the benchmarks with PERF_COUNTERS, at most 3 before Google Benchmark 1.8")
+
+# the events of BENCH_PERF_COUNTER_EVENTS Google Benchmark can count, checked once
+function(get_perf_counter_events OUT)
+    get_property(EVENTS GLOBAL PROPERTY BENCHMARK_PERF_COUNTER_EVENTS)
+    if(NOT EVENTS)
+        set(EVENTS ${BENCH_PERF_COUNTER_EVENTS})
+        string(REPLACE "," ";" EVENT_LIST "${EVENTS}")
+        list(LENGTH EVENT_LIST EVENT_COUNT)
+        # before 1.8 Google Benchmark aborts when asked for more than 3 counters
+        if(benchmark_VERSION VERSION_LESS 1.8 AND EVENT_COUNT GREATER 3)
+            list(SUBLIST EVENT_LIST 0 3 EVENT_LIST)
+            string(JOIN "," EVENTS ${EVENT_LIST})
+            message(WARNING "Google Benchmark ${benchmark_VERSION} counts at most 3 events, only ${EVENTS} are counted")
+        endif()
+        find_library(PFM_LIBRARY pfm)
+        if(NOT PFM_LIBRARY)
+            message(WARNING "libpfm is not found, the benchmarks will report no hardware counters")
+        endif()
+        set_property(GLOBAL PROPERTY BENCHMARK_PERF_COUNTER_EVENTS ${EVENTS})
+    endif()
+    set(${OUT} ${EVENTS} PARENT_SCOPE)
+endfunction()
+
+# the timings vary by a few percent between CI runs, the instruction count check runs every
+# benchmark for a single iteration under cachegrind and compares its Ir, D1mr and LLmr counts
+# with bench/baseline/<name>.txt, the <name>-instruction-count target rewrites that baseline
+option(BENCH_INSTRUCTION_COUNT "add a ctest checking the cachegrind counts of every benchmark" OFF)
+set(BENCH_INSTRUCTION_COUNT_TOLERANCE 1 CACHE STRING
+    "percentage the cachegrind counts may grow over the baseline, such as 1 or 0.5")
+find_program(VALGRIND valgrind)
+if(benchmark_VERSION VERSION_LESS 1.8)
+    set(BENCH_SINGLE_ITERATION --benchmark_min_time=0)
+else()
+    set(BENCH_SINGLE_ITERATION --benchmark_min_time=1x)
+endif()
+
+function(add_instruction_count_check BENCH_NAME)
+    if(NOT VALGRIND)
+        message(WARNING "valgrind is not found, the instruction count check of ${BENCH_NAME} is skipped")
+        return()
+    endif()
+    set(INSTRUCTION_COUNT_ARGS
+        -DVALGRIND=${VALGRIND}
+        -DBENCHMARK=$<TARGET_FILE:${BENCH_NAME}>
+        -DBENCHMARK_OPTIONS=${BENCH_SINGLE_ITERATION}
+        -DBASELINE=${CMAKE_CURRENT_SOURCE_DIR}/baseline/${BENCH_NAME}.txt
+        -DCACHEGRIND_OUT=${CMAKE_CURRENT_BINARY_DIR}/${BENCH_NAME}.cachegrind.out
+        -DTOLERANCE=${BENCH_INSTRUCTION_COUNT_TOLERANCE})
+    add_custom_target(${BENCH_NAME}-instruction-count
+        COMMAND ${CMAKE_COMMAND} ${INSTRUCTION_COUNT_ARGS} -DUPDATE_BASELINE=ON
+            -P ${PROJECT_SOURCE_DIR}/cmake_modules/instruction_count.cmake
+        DEPENDS ${BENCH_NAME}
+        USES_TERMINAL
+        VERBATIM)
+    add_test(NAME ${BENCH_NAME}.instruction_count
+        COMMAND ${CMAKE_COMMAND} ${INSTRUCTION_COUNT_ARGS}
+            -P ${PROJECT_SOURCE_DIR}/cmake_modules/instruction_count.cmake)
+    set_tests_properties(${BENCH_NAME}.instruction_count PROPERTIES LABELS instruction_count)
+endfunction()
+
+# the AllocCounters and NoAllocRegion of support/alloc_counter.h count the heap allocations of
+# the benchmarks linking the replaced global operator new and delete of support/alloc_counter.cpp,
+# in the other benchmarks they count nothing
+option(BENCH_COUNT_ALLOCS "count the heap allocations of every benchmark" OFF)
+
+# add_benchmark(BENCH_NAME SOURCE... [PERF_COUNTERS] [INSTRUCTION_COUNT] [COUNT_ALLOCS])
+# PERF_COUNTERS counts BENCH_PERF_COUNTER_EVENTS for this benchmark even without BENCH_PERF_COUNTERS
+# INSTRUCTION_COUNT adds the instruction count check even without BENCH_INSTRUCTION_COUNT
+# COUNT_ALLOCS counts the heap allocations of this benchmark even without BENCH_COUNT_ALLOCS
+function(add_benchmark BENCH_NAME)
+    cmake_parse_arguments(PARSE_ARGV 1 ARG "PERF_COUNTERS;INSTRUCTION_COUNT;COUNT_ALLOCS" "" "")
+    add_executable(${BENCH_NAME} ${ARG_UNPARSED_ARGUMENTS})
+    target_include_directories(${BENCH_NAME} PRIVATE ${CMAKE_CURRENT_SOURCE_DIR}/support)
+    target_link_libraries(${BENCH_NAME}
+        PRIVATE
+            ${LIBRARIES_FOR_TEST}
+            benchmark
+            Threads::Threads)
+    if(ARG_COUNT_ALLOCS OR BENCH_COUNT_ALLOCS)
+        if(NOT TARGET alloc_counter)
+            add_library(alloc_counter OBJECT ${CMAKE_CURRENT_SOURCE_DIR}/support/alloc_counter.cpp)
+            target_link_libraries(alloc_counter PUBLIC benchmark)
+            target_compile_definitions(alloc_counter PUBLIC BENCH_COUNT_ALLOCS)
+        endif()
+        target_link_libraries(${BENCH_NAME} PRIVATE alloc_counter)
+    endif()
+    if(ENABLE_PCH AND (ARG_COUNT_ALLOCS OR BENCH_COUNT_ALLOCS))
+        # the BENCH_COUNT_ALLOCS definition doesn't match the one of bench_pch
+        target_precompile_headers(${BENCH_NAME} PRIVATE <benchmark/benchmark.h> ${PROJECT_PCH_HEADERS})
+    elseif(ENABLE_PCH)
+        target_precompile_headers(${BENCH_NAME} REUSE_FROM bench_pch)
+    endif()
+    set_property(GLOBAL APPEND PROPERTY BENCHMARK_TARGETS ${BENCH_NAME})
+    if(ARG_PERF_COUNTERS OR BENCH_PERF_COUNTERS)
+        get_perf_counter_events(EVENTS)
+        set_property(GLOBAL PROPERTY BENCHMARK_PERF_COUNTERS_${BENCH_NAME} ${EVENTS})
+    endif()
+    if(ARG_INSTRUCTION_COUNT OR BENCH_INSTRUCTION_COUNT)
+        add_instruction_count_check(${BENCH_NAME})
+    endif()
+endfunction()
+
+# the bench preset turns it on, the numbers taken while the CPU changes its clock are not comparable
+option(BENCH_CHECK_CPU_SCALING "run-benchmarks warns when CPU frequency scaling or turbo boost may skew the benchmarks" OFF)
+# a list of CPUs for taskset, such as 2 or 2-3, keep them free of other work, e.g. with isolcpus=
+set(BENCH_CPU_SET "" CACHE STRING "CPUs run-benchmarks pins the benchmarks to, empty for no pinning")
+
+# BENCHMARK_SRCS is listed in sources.cmake of the repo root, run 'cmaker sync' after adding a
+# benchmark. run-benchmarks passes BENCHMARK_OPTIONS_<name> to the benchmark <name>, such as
+#     set(BENCHMARK_OPTIONS_bench_example --benchmark_repetitions=10 --benchmark_min_time=0.5)
+foreach(BENCH_SRC ${BENCHMARK_SRCS})
+    get_filename_component(BENCH_NAME ${BENCH_SRC} NAME_WE)
+    add_benchmark(${BENCH_NAME} ${BENCH_SRC})
+endforeach()
+
+# run-benchmarks runs every benchmark on BENCH_CPU_SET, stamps its JSON output with the git
+# revision, compiler, flags, target ISA and CPU model, adds IPC and MPKI to the benchmarks with
+# hardware counters and files it under BENCHMARK_RESULTS_DIR/<name>/, see `cmaker bench-history`
+set(BENCHMARK_RESULTS_DIR ${PROJECT_SOURCE_DIR}/build/bench-results CACHE PATH
+    "history of the run-benchmarks results, shared by every build dir")
+# the calibration of the build host, written by the machine-bench target of bench/machine, see
+# `cmaker template machine-bench`, run-benchmarks copies it into the context of every result
+cmake_host_system_information(RESULT BENCH_HOST_NAME QUERY HOSTNAME)
+set(MACHINE_BENCH_FILE ${PROJECT_SOURCE_DIR}/build/machine/${BENCH_HOST_NAME}.json CACHE FILEPATH
+    "calibration of the build host, written by the machine-bench target")
+if(EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/machine/CMakeLists.txt)
+    add_subdirectory(machine)
+endif()
+# one build of the allocation workloads per installed allocator, see the compare-allocators target
+if(EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/allocator/CMakeLists.txt)
+    add_subdirectory(allocator)
+endif()
+
+get_property(BENCHMARK_TARGETS GLOBAL PROPERTY BENCHMARK_TARGETS)
+string(TOUPPER "${CMAKE_BUILD_TYPE}" BENCHMARK_BUILD_TYPE)
+set(RUN_BENCHMARKS_CONFIG "set(SOURCE_DIR [==[${PROJECT_SOURCE_DIR}]==])
+set(BENCHMARK_RESULTS_DIR [==[${BENCHMARK_RESULTS_DIR}]==])
+set(COMPILER [==[${CMAKE_CXX_COMPILER_ID} ${CMAKE_CXX_COMPILER_VERSION}]==])
+set(CXX_FLAGS [==[${CMAKE_CXX_FLAGS} ${CMAKE_CXX_FLAGS_${BENCHMARK_BUILD_TYPE}}]==])
+set(BUILD_TYPE [==[$<CONFIG>]==])
+set(CHECK_CPU_SCALING [==[${BENCH_CHECK_CPU_SCALING}]==])
+set(CPU_SET [==[${BENCH_CPU_SET}]==])
+set(MACHINE_BENCH_FILE [==[${MACHINE_BENCH_FILE}]==])
+set(TARGET_ISA [==[${TARGET_ISA}]==])
+")
+foreach(BENCH_TARGET ${BENCHMARK_TARGETS})
+    get_property(BENCH_PERF_COUNTER_LIST GLOBAL PROPERTY BENCHMARK_PERF_COUNTERS_${BENCH_TARGET})
+    string(APPEND RUN_BENCHMARKS_CONFIG "list(APPEND BENCHMARKS ${BENCH_TARGET})
+set(BENCHMARK_FILE_${BENCH_TARGET} [==[$<TARGET_FILE:${BENCH_TARGET}>]==])
+set(BENCHMARK_OPTIONS_${BENCH_TARGET} [==[${BENCHMARK_OPTIONS_${BENCH_TARGET}}]==])
+set(BENCHMARK_PERF_COUNTERS_${BENCH_TARGET} [==[${BENCH_PERF_COUNTER_LIST}]==])
+")
+endforeach()
+file(GENERATE OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/run_benchmarks_$<CONFIG>.cmake
+    CONTENT "${RUN_BENCHMARKS_CONFIG}")
+add_custom_target(run-benchmarks
+    COMMAND ${CMAKE_COMMAND} -DCONFIG_FILE=${CMAKE_CURRENT_BINARY_DIR}/run_benchmarks_$<CONFIG>.cmake
+        -P ${PROJECT_SOURCE_DIR}/cmake_modules/run_benchmarks.cmake
+    DEPENDS ${BENCHMARK_TARGETS}
+    WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}
+    USES_TERMINAL
+    VERBATIM)
+
+# with PGO=generate, the pgo-train target runs every benchmark to collect the profiles
+if(PGO STREQUAL "generate")
+    get_property(PGO_TRAIN_TARGETS GLOBAL PROPERTY BENCHMARK_TARGETS)
+    set(PGO_TRAIN_COMMANDS)
+    foreach(BENCH_TARGET ${PGO_TRAIN_TARGETS})
+        list(APPEND PGO_TRAIN_COMMANDS COMMAND $<TARGET_FILE:${BENCH_TARGET}>)
+    endforeach()
+    add_custom_target(pgo-train
+        ${PGO_TRAIN_COMMANDS}
+        DEPENDS ${PGO_TRAIN_TARGETS}
+        WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}
+        COMMENT "running the benchmarks to collect the PGO profiles"
+        VERBATIM)
+endif()
+)");
+
+    EmitFile(ctx, "cmake_modules/bench_utils.cmake", R"(# included by the cmake -P scripts of the benchmarks: run_benchmarks.cmake,
+# instruction_count.cmake and compare_allocators.cmake
+
+# math() only knows integers, a decimal such as 1234.5 or 1.2345e+06 of the JSON output is read
+# as an integer count of 10^-DECIMALS, 3 decimals give thousandths, anything else reads as 0
+function(to_fixed_point OUT VALUE DECIMALS)
+    if(NOT VALUE MATCHES "^([0-9]*)\\.?([0-9]*)[eE]?([-+]?[0-9]*)$")
+        set(${OUT} 0 PARENT_SCOPE)
+        return()
+    endif()
+    set(DIGITS "${CMAKE_MATCH_1}${CMAKE_MATCH_2}")
+    string(LENGTH "${CMAKE_MATCH_2}" FRACTION_LENGTH)
+    set(EXPONENT "${CMAKE_MATCH_3}")
+    if(EXPONENT STREQUAL "")
+        set(EXPONENT 0)
+    endif()
+    math(EXPR SHIFT "${EXPONENT} - ${FRACTION_LENGTH} + ${DECIMALS}")
+    # 15 significant digits keep the products below 2^63
+    string(REGEX REPLACE "^0+" "" DIGITS "${DIGITS}")
+    string(LENGTH "${DIGITS}" DIGITS_LENGTH)
+    if(DIGITS_LENGTH GREATER 15)
+        math(EXPR SHIFT "${SHIFT} + ${DIGITS_LENGTH} - 15")
+        string(SUBSTRING "${DIGITS}" 0 15 DIGITS)
+        set(DIGITS_LENGTH 15)
+    endif()
+    if(SHIFT GREATER 0)
+        string(REPEAT "0" ${SHIFT} ZEROS)
+        string(APPEND DIGITS "${ZEROS}")
+    elseif(SHIFT LESS 0)
+        math(EXPR DIGITS_LENGTH "${DIGITS_LENGTH} + ${SHIFT}")
+        if(DIGITS_LENGTH GREATER 0)
+            string(SUBSTRING "${DIGITS}" 0 ${DIGITS_LENGTH} DIGITS)
+        else()
+            set(DIGITS "")
+        endif()
+    endif()
+    if(DIGITS STREQUAL "")
+        set(DIGITS 0)
+    endif()
+    set(${OUT} ${DIGITS} PARENT_SCOPE)
+endfunction()
+)");
+
+    EmitFile(ctx, "cmake_modules/run_benchmarks.cmake", R"(# run by the run-benchmarks target of bench/CMakeLists.txt:
+#     cmake -DCONFIG_FILE=<build dir>/bench/run_benchmarks_<config>.cmake -P run_benchmarks.cmake
+# the config file lists BENCHMARKS with their BENCHMARK_FILE_<name> and BENCHMARK_OPTIONS_<name>
+include(${CONFIG_FILE})
+include(${CMAKE_CURRENT_LIST_DIR}/bench_utils.cmake)
+
+function(json_quote OUT VALUE)
+    string(REPLACE "\\" "\\\\" VALUE "${VALUE}")
+    string(REPLACE "\"" "\\\"" VALUE "${VALUE}")
+    set(${OUT} "\"${VALUE}\"" PARENT_SCOPE)
+endfunction()
+
+# NUMERATOR * SCALE / DENOMINATOR with three decimals, both given in thousandths
+function(ratio_text OUT NUMERATOR DENOMINATOR SCALE)
+    while(NUMERATOR GREATER 9000000000)
+        math(EXPR NUMERATOR "${NUMERATOR} / 10")
+        math(EXPR DENOMINATOR "${DENOMINATOR} / 10")
+    endwhile()
+    if(DENOMINATOR EQUAL 0)
+        set(${OUT} "" PARENT_SCOPE)
+        return()
+    endif()
+    math(EXPR QUOTIENT "${NUMERATOR} * ${SCALE} * 1000 / ${DENOMINATOR}")
+    math(EXPR WHOLE "${QUOTIENT} / 1000")
+    math(EXPR FRACTION "${QUOTIENT} % 1000 + 1000")
+    string(SUBSTRING "${FRACTION}" 1 3 FRACTION)
+    set(${OUT} "${WHOLE}.${FRACTION}" PARENT_SCOPE)
+endfunction()
+
+# the counters Google Benchmark reports per iteration under the libpfm event names
+function(add_derived_counters JSON_VAR)
+    set(JSON "${${JSON_VAR}}")
+    string(JSON BENCH_COUNT LENGTH "${JSON}" benchmarks)
+    if(BENCH_COUNT EQUAL 0)
+        return()
+    endif()
+    math(EXPR LAST "${BENCH_COUNT} - 1")
+    set(FOUND_COUNTERS OFF)
+    foreach(I RANGE ${LAST})
+        string(JSON INSTRUCTIONS ERROR_VARIABLE MISSING GET "${JSON}" benchmarks ${I} INSTRUCTIONS)
+        if(MISSING)
+            continue()
+        endif()
+        set(FOUND_COUNTERS ON)
+        to_fixed_point(INSTRUCTIONS "${INSTRUCTIONS}" 3)
+        foreach(DERIVED "IPC;CYCLES;1" "CACHE_MPKI;CACHE-MISSES;1000" "BRANCH_MPKI;BRANCH-MISSES;1000")
+            list(GET DERIVED 0 DERIVED_NAME)
+            list(GET DERIVED 1 COUNTER)
+            list(GET DERIVED 2 SCALE)
+            string(JSON COUNT ERROR_VARIABLE MISSING GET "${JSON}" benchmarks ${I} ${COUNTER})
+            if(MISSING)
+                continue()
+            endif()
+            to_fixed_point(COUNT "${COUNT}" 3)
+            # instructions per cycle, or misses per thousand instructions
+            if(DERIVED_NAME STREQUAL "IPC")
+                ratio_text(VALUE ${INSTRUCTIONS} ${COUNT} ${SCALE})
+            else()
+                ratio_text(VALUE ${COUNT} ${INSTRUCTIONS} ${SCALE})
+            endif()
+            if(NOT VALUE STREQUAL "")
+                string(JSON JSON SET "${JSON}" benchmarks ${I} ${DERIVED_NAME} ${VALUE})
+            endif()
+        endforeach()
+    endforeach()
+    if(NOT FOUND_COUNTERS)
+        message(WARNING "no hardware counter in the results, Google Benchmark needs libpfm and "
+            "a kernel.perf_event_paranoid of 2 or less to count")
+    endif()
+    set(${JSON_VAR} "${JSON}" PARENT_SCOPE)
+endfunction()
+
+# a taskset CPU list such as 0,2-3 to the numbers of the CPUs
+function(expand_cpu_list OUT CPU_LIST)
+    set(CPUS)
+    string(REPLACE "," ";" CPU_RANGES "${CPU_LIST}")
+    foreach(CPU_RANGE ${CPU_RANGES})
+        if(CPU_RANGE MATCHES "^([0-9]+)-([0-9]+)$")
+            foreach(CPU RANGE ${CMAKE_MATCH_1} ${CMAKE_MATCH_2})
+                list(APPEND CPUS ${CPU})
+            endforeach()
+        else()
+            list(APPEND CPUS ${CPU_RANGE})
+        endif()
+    endforeach()
+    set(${OUT} ${CPUS} PARENT_SCOPE)
+endfunction()
+
+# the numbers taken while the CPU changes its clock are not comparable
+function(check_cpu_scaling CPU_LIST)
+    if(CPU_LIST STREQUAL "")
+        file(GLOB CPU_GOVERNOR_FILES /sys/devices/system/cpu/cpu*/cpufreq/scaling_governor)
+    else()
+        expand_cpu_list(CPUS "${CPU_LIST}")
+        set(CPU_GOVERNOR_FILES)
+        foreach(CPU ${CPUS})
+            list(APPEND CPU_GOVERNOR_FILES /sys/devices/system/cpu/cpu${CPU}/cpufreq/scaling_governor)
+        endforeach()
+    endif()
+    foreach(CPU_GOVERNOR_FILE ${CPU_GOVERNOR_FILES})
+        if(NOT EXISTS ${CPU_GOVERNOR_FILE})
+            continue()
+        endif()
+        file(READ ${CPU_GOVERNOR_FILE} CPU_GOVERNOR)
+        string(STRIP "${CPU_GOVERNOR}" CPU_GOVERNOR)
+        if(NOT CPU_GOVERNOR STREQUAL "performance")
+            message(WARNING "CPU frequency governor is ${CPU_GOVERNOR}, run `sudo cpupower frequency-set -g performance` before benchmarking")
+            break()
+        endif()
+    endforeach()
+    if(EXISTS /sys/devices/system/cpu/intel_pstate/no_turbo)
+        file(READ /sys/devices/system/cpu/intel_pstate/no_turbo CPU_NO_TURBO)
+        if(CPU_NO_TURBO MATCHES "^0")
+            message(WARNING "turbo boost is on, write 1 to /sys/devices/system/cpu/intel_pstate/no_turbo before benchmarking")
+        endif()
+    elseif(EXISTS /sys/devices/system/cpu/cpufreq/boost)
+        file(READ /sys/devices/system/cpu/cpufreq/boost CPU_BOOST)
+        if(CPU_BOOST MATCHES "^1")
+            message(WARNING "CPU boost is on, write 0 to /sys/devices/system/cpu/cpufreq/boost before benchmarking")
+        endif()
+    endif()
+endfunction()
+
+if(CHECK_CPU_SCALING)
+    check_cpu_scaling("${CPU_SET}")
+endif()
+set(PIN_COMMAND)
+if(NOT CPU_SET STREQUAL "")
+    find_program(TASKSET taskset)
+    if(TASKSET)
+        set(PIN_COMMAND ${TASKSET} -c ${CPU_SET})
+    else()
+        message(WARNING "taskset is not found, the benchmarks run unpinned instead of on CPUs ${CPU_SET}")
+    endif()
+endif()
+
+execute_process(COMMAND git rev-parse --short=12 HEAD
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE GIT_SHA
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    ERROR_QUIET)
+if(GIT_SHA STREQUAL "")
+    set(GIT_SHA "unknown")
+else()
+    execute_process(COMMAND git status --porcelain --untracked-files=no
+        WORKING_DIRECTORY ${SOURCE_DIR}
+        OUTPUT_VARIABLE GIT_CHANGES
+        ERROR_QUIET)
+    if(NOT GIT_CHANGES STREQUAL "")
+        string(APPEND GIT_SHA "-dirty")
+    endif()
+endif()
+if(EXISTS /proc/cpuinfo)
+    file(STRINGS /proc/cpuinfo CPU_MODEL REGEX "^model name" LIMIT_COUNT 1)
+    string(REGEX REPLACE "^model name[ \t]*:[ \t]*" "" CPU_MODEL "${CPU_MODEL}")
+endif()
+if(NOT CPU_MODEL)
+    cmake_host_system_information(RESULT CPU_MODEL QUERY PROCESSOR_DESCRIPTION)
+endif()
+string(STRIP "${CPU_MODEL}" CPU_MODEL)
+string(STRIP "${CXX_FLAGS}" CXX_FLAGS)
+string(TIMESTAMP RUN_TIMESTAMP "%Y%m%dT%H%M%SZ" UTC)
+set(MACHINE_JSON)
+if(MACHINE_BENCH_FILE AND EXISTS ${MACHINE_BENCH_FILE})
+    file(READ ${MACHINE_BENCH_FILE} MACHINE_JSON)
+endif()
+
+set(FAILED_BENCHMARKS)
+foreach(BENCH ${BENCHMARKS})
+    # the file names sort in the order of the runs
+    set(RESULT_FILE ${BENCHMARK_RESULTS_DIR}/${BENCH}/${RUN_TIMESTAMP}_${GIT_SHA}.json)
+    file(MAKE_DIRECTORY ${BENCHMARK_RESULTS_DIR}/${BENCH})
+    set(PERF_COUNTER_OPTION)
+    if(NOT BENCHMARK_PERF_COUNTERS_${BENCH} STREQUAL "")
+        set(PERF_COUNTER_OPTION --benchmark_perf_counters=${BENCHMARK_PERF_COUNTERS_${BENCH}})
+    endif()
+    string(JOIN " " BENCH_COMMAND_LINE ${PIN_COMMAND} ${BENCH} ${PERF_COUNTER_OPTION}
+        ${BENCHMARK_OPTIONS_${BENCH}})
+    message(STATUS "running ${BENCH_COMMAND_LINE}")
+    execute_process(COMMAND ${PIN_COMMAND} ${BENCHMARK_FILE_${BENCH}}
+            --benchmark_out=${RESULT_FILE}
+            --benchmark_out_format=json
+            ${PERF_COUNTER_OPTION}
+            ${BENCHMARK_OPTIONS_${BENCH}}
+        RESULT_VARIABLE BENCH_RESULT)
+    if(NOT BENCH_RESULT EQUAL 0 OR NOT EXISTS ${RESULT_FILE})
+        list(APPEND FAILED_BENCHMARKS ${BENCH})
+        file(REMOVE ${RESULT_FILE})
+        continue()
+    endif()
+
+    file(READ ${RESULT_FILE} RESULT_JSON)
+    foreach(KEY GIT_SHA COMPILER CXX_FLAGS TARGET_ISA BUILD_TYPE CPU_MODEL RUN_TIMESTAMP)
+        string(TOLOWER ${KEY} CONTEXT_KEY)
+        json_quote(CONTEXT_VALUE "${${KEY}}")
+        string(JSON RESULT_JSON SET "${RESULT_JSON}" context ${CONTEXT_KEY} "${CONTEXT_VALUE}")
+    endforeach()
+    if(MACHINE_JSON)
+        string(JSON RESULT_JSON SET "${RESULT_JSON}" context machine "${MACHINE_JSON}")
+    endif()
+    if(PERF_COUNTER_OPTION)
+        add_derived_counters(RESULT_JSON)
+    endif()
+    file(WRITE ${RESULT_FILE} "${RESULT_JSON}")
+    message(STATUS "saved ${RESULT_FILE}")
+endforeach()
+
+if(FAILED_BENCHMARKS)
+    message(FATAL_ERROR "failed benchmarks: ${FAILED_BENCHMARKS}")
+endif()
+)");
+
+    EmitFile(ctx, "cmake_modules/instruction_count.cmake", R"(# run by the instruction count check of add_benchmark in bench/CMakeLists.txt:
+#     cmake -DVALGRIND=<valgrind> -DBENCHMARK=<benchmark> -DBENCHMARK_OPTIONS=<options>
+#         -DBASELINE=<baseline file> -DCACHEGRIND_OUT=<file> -DTOLERANCE=<percent>
+#         [-DUPDATE_BASELINE=ON] -P instruction_count.cmake
+# runs the benchmark under cachegrind and compares the Ir, D1mr and LLmr counts with the
+# baseline, fails when any of them grew by more than TOLERANCE percent, with UPDATE_BASELINE it
+# writes the counts as the new baseline instead
+include(${CMAKE_CURRENT_LIST_DIR}/bench_utils.cmake)
+set(CHECKED_EVENTS Ir D1mr LLmr)
+
+file(REMOVE ${CACHEGRIND_OUT})
+execute_process(COMMAND ${VALGRIND} --tool=cachegrind --cache-sim=yes
+        --cachegrind-out-file=${CACHEGRIND_OUT} ${BENCHMARK} ${BENCHMARK_OPTIONS}
+    OUTPUT_QUIET
+    ERROR_VARIABLE VALGRIND_ERROR
+    RESULT_VARIABLE VALGRIND_RESULT)
+if(NOT VALGRIND_RESULT EQUAL 0 OR NOT EXISTS ${CACHEGRIND_OUT})
+    message(FATAL_ERROR "cachegrind failed on ${BENCHMARK}:\n${VALGRIND_ERROR}")
+endif()
+
+# the out file lists the event names on its events: line and their totals on its summary: line
+file(STRINGS ${CACHEGRIND_OUT} EVENT_NAMES REGEX "^events:")
+file(STRINGS ${CACHEGRIND_OUT} EVENT_TOTALS REGEX "^summary:")
+string(REGEX REPLACE "^events: *" "" EVENT_NAMES "${EVENT_NAMES}")
+string(REGEX REPLACE "^summary: *" "" EVENT_TOTALS "${EVENT_TOTALS}")
+separate_arguments(EVENT_NAMES UNIX_COMMAND "${EVENT_NAMES}")
+separate_arguments(EVENT_TOTALS UNIX_COMMAND "${EVENT_TOTALS}")
+foreach(EVENT_NAME ${EVENT_NAMES})
+    list(POP_FRONT EVENT_TOTALS EVENT_TOTAL)
+    set(COUNT_${EVENT_NAME} ${EVENT_TOTAL})
+endforeach()
+if(NOT DEFINED COUNT_D1mr OR NOT DEFINED COUNT_ILmr OR NOT DEFINED COUNT_DLmr)
+    message(FATAL_ERROR "no cache miss totals in ${CACHEGRIND_OUT}, is it written with --cache-sim=yes?")
+endif()
+# the last level misses of the instruction and data reads, as cg_annotate sums them
+math(EXPR COUNT_LLmr "${COUNT_ILmr} + ${COUNT_DLmr}")
+
+get_filename_component(BENCH_NAME ${BENCHMARK} NAME_WE)
+if(UPDATE_BASELINE)
+    set(BASELINE_TEXT "# cachegrind counts of ${BENCH_NAME}, written by its ${BENCH_NAME}-instruction-count target\n")
+    foreach(EVENT ${CHECKED_EVENTS})
+        string(APPEND BASELINE_TEXT "${EVENT} ${COUNT_${EVENT}}\n")
+    endforeach()
+    file(WRITE ${BASELINE} "${BASELINE_TEXT}")
+    message(STATUS "Ir ${COUNT_Ir}, D1mr ${COUNT_D1mr}, LLmr ${COUNT_LLmr} written to ${BASELINE}")
+    return()
+endif()
+
+if(NOT EXISTS ${BASELINE})
+    message(FATAL_ERROR "${BASELINE} is missing, build the ${BENCH_NAME}-instruction-count target to write it")
+endif()
+file(STRINGS ${BASELINE} BASELINE_LINES REGEX "^[A-Za-z0-9]+ [0-9]+$")
+foreach(BASELINE_LINE ${BASELINE_LINES})
+    string(REPLACE " " ";" BASELINE_LINE "${BASELINE_LINE}")
+    list(GET BASELINE_LINE 0 EVENT)
+    list(GET BASELINE_LINE 1 BASELINE_${EVENT})
+endforeach()
+
+# the tolerance in tenths of a percent
+if(NOT TOLERANCE MATCHES "^[0-9]+(\\.[0-9]*)?$")
+    message(FATAL_ERROR "invalid TOLERANCE ${TOLERANCE}, expects a percentage such as 1 or 0.5")
+endif()
+to_fixed_point(TOLERANCE_PERMILLE "${TOLERANCE}" 1)
+
+set(GROWN_EVENTS)
+foreach(EVENT ${CHECKED_EVENTS})
+    if(NOT DEFINED BASELINE_${EVENT})
+        message(FATAL_ERROR "no ${EVENT} count in ${BASELINE}")
+    endif()
+    set(BASE ${BASELINE_${EVENT}})
+    set(COUNT ${COUNT_${EVENT}})
+    if(BASE EQUAL 0)
+        set(DELTA "n/a")
+        set(GROWN ${COUNT})
+    else()
+        math(EXPR DELTA_PERMILLE "(${COUNT} - ${BASE}) * 1000 / ${BASE}")
+        math(EXPR DELTA_WHOLE "${DELTA_PERMILLE} / 10")
+        math(EXPR DELTA_TENTHS "${DELTA_PERMILLE} % 10")
+        if(DELTA_TENTHS LESS 0)
+            math(EXPR DELTA_TENTHS "-${DELTA_TENTHS}")
+            if(DELTA_WHOLE EQUAL 0)
+                set(DELTA_WHOLE "-0")
+            endif()
+        endif()
+        set(DELTA "${DELTA_WHOLE}.${DELTA_TENTHS}%")
+        math(EXPR SCALED_COUNT "${COUNT} * 1000")
+        math(EXPR COUNT_LIMIT "${BASE} * 1000 + ${BASE} * ${TOLERANCE_PERMILLE}")
+        set(GROWN OFF)
+        if(SCALED_COUNT GREATER COUNT_LIMIT)
+            set(GROWN ON)
+        endif()
+    endif()
+    message(STATUS "${EVENT}: ${COUNT}, baseline ${BASE}, ${DELTA}")
+    if(GROWN)
+        list(APPEND GROWN_EVENTS ${EVENT})
+    endif()
+endforeach()
+
+if(GROWN_EVENTS)
+    message(FATAL_ERROR "${GROWN_EVENTS} of ${BENCH_NAME} grew by more than ${TOLERANCE}% over ${BASELINE}, "
+        "build the ${BENCH_NAME}-instruction-count target to accept the new counts")
+endif()
+)");
+
+    EmitFile(ctx, "bench/support/alloc_counter.h", R"(#pragma once
+// counts the heap allocations of the calling thread through the replaced global operator new of
+// alloc_counter.cpp, which add_benchmark(... COUNT_ALLOCS) links, the other benchmarks count nothing
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+struct AllocCounts
+{
+    std::uint64_t allocs;
+    std::uint64_t bytes;
+    std::uint64_t frees;
+};
+
+#ifdef BENCH_COUNT_ALLOCS
+// the counts of the calling thread since it started
+AllocCounts CurrentAllocCounts();
+#else
+inline AllocCounts CurrentAllocCounts()
+{
+    return AllocCounts{0, 0, 0};
+}
+#endif
+
+// reports the allocs/iter and bytes/iter user counters of the benchmark when it goes out of
+// scope, keep the loop alone in its scope, since the counters set after the loop, such as
+// SetItemsProcessed, allocate as well:
+//     {
+//         AllocCounters allocs(state);
+//         for (auto _ : state) { ... }
+//     }
+class AllocCounters
+{
+public:
+    explicit AllocCounters(benchmark::State &state) : state(state), start(CurrentAllocCounts())
+    {
+    }
+    AllocCounters(AllocCounters const &) = delete;
+    AllocCounters &operator=(AllocCounters const &) = delete;
+    ~AllocCounters()
+    {
+#ifdef BENCH_COUNT_ALLOCS
+        AllocCounts end = CurrentAllocCounts();
+        state.counters["allocs/iter"] = benchmark::Counter(
+            static_cast<double>(end.allocs - start.allocs), benchmark::Counter::kAvgIterations);
+        state.counters["bytes/iter"] = benchmark::Counter(
+            static_cast<double>(end.bytes - start.bytes), benchmark::Counter::kAvgIterations);
+#endif
+    }
+
+private:
+    benchmark::State &state;
+    AllocCounts start;
+};
+
+// fails the benchmark when the code in its scope allocates, such as the hot path in the loop:
+//     for (auto _ : state) { NoAllocRegion no_alloc(state); ... }
+// the loop still runs to its end, the benchmark reports the error instead of its timings
+class NoAllocRegion
+{
+public:
+    explicit NoAllocRegion(benchmark::State &state) : state(state), start(CurrentAllocCounts())
+    {
+    }
+    NoAllocRegion(NoAllocRegion const &) = delete;
+    NoAllocRegion &operator=(NoAllocRegion const &) = delete;
+    ~NoAllocRegion()
+    {
+        if (CurrentAllocCounts().allocs != start.allocs && !state.error_occurred())
+        {
+            state.SkipWithError("heap allocation in a NoAllocRegion");
+        }
+    }
+
+private:
+    benchmark::State &state;
+    AllocCounts start;
+};
+)");
+
+    EmitFile(ctx, "bench/support/alloc_counter.cpp", R"(#include "alloc_counter.h"
+#include <cstdlib>
+#include <new>
+
+// constant initialized, so operator new may count before main() and on any thread
+static thread_local AllocCounts counts = {0, 0, 0};
+
+AllocCounts CurrentAllocCounts()
+{
+    return counts;
+}
+
+static void *CountedAlloc(std::size_t size)
+{
+    ++counts.allocs;
+    counts.bytes += size;
+    for (;;)
+    {
+        void *ptr = std::malloc(size == 0 ? 1 : size);
+        if (ptr)
+        {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+static void CountedFree(void *ptr) noexcept
+{
+    if (ptr)
+    {
+        ++counts.frees;
+        std::free(ptr);
+    }
+}
+
+void *operator new(std::size_t size)
+{
+    return CountedAlloc(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return CountedAlloc(size);
+}
+
+void *operator new(std::size_t size, std::nothrow_t const &) noexcept
+{
+    try
+    {
+        return CountedAlloc(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, std::nothrow_t const &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    CountedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    CountedFree(ptr);
+}
+
+void operator delete(void *ptr, std::nothrow_t const &) noexcept
+{
+    CountedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::nothrow_t const &) noexcept
+{
+    CountedFree(ptr);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    CountedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    CountedFree(ptr);
+}
+#endif
+
+#ifdef __cpp_aligned_new
+static void *CountedAlignedAlloc(std::size_t size, std::align_val_t align)
+{
+    ++counts.allocs;
+    counts.bytes += size;
+    std::size_t alignment = static_cast<std::size_t>(align);
+    for (;;)
+    {
+#ifdef _WIN32
+        void *ptr = _aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+        void *ptr = nullptr;
+        if (posix_memalign(&ptr, alignment < sizeof(void *) ? sizeof(void *) : alignment,
+                size == 0 ? 1 : size) != 0)
+        {
+            ptr = nullptr;
+        }
+#endif
+        if (ptr)
+        {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+static void CountedAlignedFree(void *ptr) noexcept
+{
+    if (ptr)
+    {
+        ++counts.frees;
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+}
+
+void *operator new(std::size_t size, std::align_val_t align)
+{
+    return CountedAlignedAlloc(size, align);
+}
+
+void *operator new[](std::size_t size, std::align_val_t align)
+{
+    return CountedAlignedAlloc(size, align);
+}
+
+void *operator new(std::size_t size, std::align_val_t align, std::nothrow_t const &) noexcept
+{
+    try
+    {
+        return CountedAlignedAlloc(size, align);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, std::align_val_t align, std::nothrow_t const &) noexcept
+{
+    return operator new(size, align, std::nothrow);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    CountedAlignedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    CountedAlignedFree(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    CountedAlignedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    CountedAlignedFree(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, std::nothrow_t const &) noexcept
+{
+    CountedAlignedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, std::nothrow_t const &) noexcept
+{
+    CountedAlignedFree(ptr);
+}
+#endif
+)");
+
+    EmitFile(ctx, "bench/allocator/CMakeLists.txt", R"(# the allocation workloads of bench_allocator.cpp built once per heap allocator installed on the
+# host, `cmake --build <build dir> --target compare-allocators` runs them all and prints their
+# times side by side, the ALLOCATOR option of the root CMakeLists.txt doesn't apply to them
+add_executable(bench_allocator_system bench_allocator.cpp)
+target_link_libraries(bench_allocator_system PRIVATE benchmark Threads::Threads)
+set(ALLOCATOR_BENCHMARKS bench_allocator_system)
+foreach(ALLOCATOR_PACKAGE Jemalloc Mimalloc Tcmalloc)
+    find_package(${ALLOCATOR_PACKAGE} QUIET)
+    if(${ALLOCATOR_PACKAGE}_FOUND)
+        string(TOLOWER ${ALLOCATOR_PACKAGE} ALLOCATOR_NAME)
+        add_executable(bench_allocator_${ALLOCATOR_NAME} bench_allocator.cpp)
+        # linked ahead of the C library, its malloc serves every library of the process
+        target_link_libraries(bench_allocator_${ALLOCATOR_NAME}
+            PRIVATE
+                ${ALLOCATOR_PACKAGE}::${ALLOCATOR_PACKAGE}
+                benchmark
+                Threads::Threads)
+        list(APPEND ALLOCATOR_BENCHMARKS bench_allocator_${ALLOCATOR_NAME})
+    endif()
+endforeach()
+message(STATUS "allocators compared by compare-allocators: ${ALLOCATOR_BENCHMARKS}")
+
+set(ALLOCATOR_BENCHMARK_OPTIONS "" CACHE STRING
+    "options of every benchmark run by compare-allocators, such as --benchmark_filter=BM_SmallBatch")
+set(COMPARE_ALLOCATORS_CONFIG "set(RESULTS_DIR [==[${CMAKE_CURRENT_BINARY_DIR}/results]==])
+set(BENCHMARK_OPTIONS [==[${ALLOCATOR_BENCHMARK_OPTIONS}]==])
+")
+foreach(BENCH_TARGET ${ALLOCATOR_BENCHMARKS})
+    string(APPEND COMPARE_ALLOCATORS_CONFIG "list(APPEND BENCHMARKS ${BENCH_TARGET})
+set(BENCHMARK_FILE_${BENCH_TARGET} [==[$<TARGET_FILE:${BENCH_TARGET}>]==])
+")
+endforeach()
+file(GENERATE OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/compare_allocators_$<CONFIG>.cmake
+    CONTENT "${COMPARE_ALLOCATORS_CONFIG}")
+add_custom_target(compare-allocators
+    COMMAND ${CMAKE_COMMAND} -DCONFIG_FILE=${CMAKE_CURRENT_BINARY_DIR}/compare_allocators_$<CONFIG>.cmake
+        -P ${PROJECT_SOURCE_DIR}/cmake_modules/compare_allocators.cmake
+    DEPENDS ${ALLOCATOR_BENCHMARKS}
+    WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}
+    USES_TERMINAL
+    VERBATIM)
+)");
+
+    EmitFile(ctx, "bench/allocator/bench_allocator.cpp", R"(// allocation heavy workloads, built once per heap allocator by bench/allocator/CMakeLists.txt and
+// compared by the compare-allocators target, shape them after the allocations of the repo
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+// xorshift32, the sizes and the slots don't depend on the allocator under test
+static uint32_t NextRandom(uint32_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// a batch of same sized blocks allocated then freed, the fast path of one size class
+static void BM_SmallBatch(benchmark::State &state)
+{
+    auto size = static_cast<size_t>(state.range(0));
+    std::vector<void *> blocks(1024);
+    for (auto _ : state)
+    {
+        for (auto &block : blocks)
+        {
+            block = ::operator new(size);
+            benchmark::DoNotOptimize(block);
+        }
+        for (auto block : blocks)
+        {
+            ::operator delete(block);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(blocks.size()));
+}
+BENCHMARK(BM_SmallBatch)->RangeMultiplier(4)->Range(16, 4096)->ThreadRange(1, 4)->UseRealTime();
+
+// blocks of random sizes up to range(0) bytes replacing the ones of random slots, the mixed
+// lifetimes and the fragmentation of a long running service
+static void BM_RandomLifetime(benchmark::State &state)
+{
+    auto max_size = static_cast<uint32_t>(state.range(0));
+    std::vector<void *> slots(4096, nullptr);
+    uint32_t random = 2463534242u + static_cast<uint32_t>(state.thread_index());
+    for (auto _ : state)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            auto &slot = slots[NextRandom(random) % slots.size()];
+            ::operator delete(slot);
+            slot = ::operator new(16 + NextRandom(random) % max_size);
+            benchmark::DoNotOptimize(slot);
+        }
+    }
+    for (auto slot : slots)
+    {
+        ::operator delete(slot);
+    }
+    state.SetItemsProcessed(state.iterations() * 256);
+}
+BENCHMARK(BM_RandomLifetime)->Arg(512)->Arg(64 << 10)->ThreadRange(1, 4)->UseRealTime();
+
+// the node and string allocations of a map filled then destroyed
+static void BM_Containers(benchmark::State &state)
+{
+    uint32_t random = 88675123u + static_cast<uint32_t>(state.thread_index());
+    for (auto _ : state)
+    {
+        std::map<uint32_t, std::string> map;
+        for (int i = 0; i < 1000; ++i)
+        {
+            // past the small string buffer, so every string allocates
+            map.emplace(NextRandom(random), std::string(32 + i % 64, 'x'));
+        }
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_Containers)->ThreadRange(1, 4)->UseRealTime();
+
+static std::mutex exchange_mutex;
+static std::vector<void *> exchange;
+
+// blocks freed by another thread than the one which allocated them, like the messages passed from
+// a producer to a consumer, the threads swap their batches through the exchange
+static void BM_CrossThreadFree(benchmark::State &state)
+{
+    std::vector<void *> batch;
+    for (auto _ : state)
+    {
+        batch.resize(256);
+        for (auto &block : batch)
+        {
+            block = ::operator new(64);
+            benchmark::DoNotOptimize(block);
+        }
+        {
+            std::lock_guard<std::mutex> lock(exchange_mutex);
+            exchange.swap(batch);
+        }
+        // the previous batch of any thread
+        for (auto block : batch)
+        {
+            ::operator delete(block);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(exchange_mutex);
+        for (auto block : exchange)
+        {
+            ::operator delete(block);
+        }
+        exchange.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * 256);
+}
+BENCHMARK(BM_CrossThreadFree)->ThreadRange(2, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
+)");
+
+    EmitFile(ctx, "cmake_modules/compare_allocators.cmake", R"==(# run by the compare-allocators target of bench/allocator/CMakeLists.txt:
+#     cmake -DCONFIG_FILE=<build dir>/bench/allocator/compare_allocators_<config>.cmake -P compare_allocators.cmake
+# the config file lists BENCHMARKS, one build of the workloads per allocator, with their
+# BENCHMARK_FILE_<name>, every benchmark is printed with its real time under each allocator
+include(${CONFIG_FILE})
+include(${CMAKE_CURRENT_LIST_DIR}/bench_utils.cmake)
+
+# a time of the JSON output, such as 1.25e+03 with the unit us, as an integer of picoseconds
+function(time_to_ps VALUE UNIT OUT)
+    set(UNIT_DIGITS_ns 3)
+    set(UNIT_DIGITS_us 6)
+    set(UNIT_DIGITS_ms 9)
+    set(UNIT_DIGITS_s 12)
+    to_fixed_point(PS "${VALUE}" ${UNIT_DIGITS_${UNIT}})
+    set(${OUT} ${PS} PARENT_SCOPE)
+endfunction()
+
+# picoseconds printed with two decimals in the largest unit below the time, such as 1.25 us
+function(format_ps PS OUT)
+    set(SCALE 1000)
+    foreach(UNIT ns us ms s)
+        math(EXPR NEXT_SCALE "${SCALE} * 1000")
+        if(PS LESS NEXT_SCALE OR UNIT STREQUAL "s")
+            math(EXPR WHOLE "${PS} / ${SCALE}")
+            math(EXPR HUNDREDTHS "${PS} % ${SCALE} * 100 / ${SCALE}")
+            if(HUNDREDTHS LESS 10)
+                set(HUNDREDTHS "0${HUNDREDTHS}")
+            endif()
+            set(${OUT} "${WHOLE}.${HUNDREDTHS} ${UNIT}" PARENT_SCOPE)
+            return()
+        endif()
+        set(SCALE ${NEXT_SCALE})
+    endforeach()
+endfunction()
+
+# TEXT padded with spaces to WIDTH columns
+function(pad_left TEXT WIDTH OUT)
+    string(LENGTH "${TEXT}" LENGTH)
+    if(LENGTH LESS WIDTH)
+        math(EXPR PADDING "${WIDTH} - ${LENGTH}")
+        string(REPEAT " " ${PADDING} SPACES)
+        set(TEXT "${SPACES}${TEXT}")
+    endif()
+    set(${OUT} "${TEXT}" PARENT_SCOPE)
+endfunction()
+
+function(pad_right TEXT WIDTH OUT)
+    string(LENGTH "${TEXT}" LENGTH)
+    if(LENGTH LESS WIDTH)
+        math(EXPR PADDING "${WIDTH} - ${LENGTH}")
+        string(REPEAT " " ${PADDING} SPACES)
+        set(TEXT "${TEXT}${SPACES}")
+    endif()
+    set(${OUT} "${TEXT}" PARENT_SCOPE)
+endfunction()
+
+separate_arguments(OPTIONS UNIX_COMMAND "${BENCHMARK_OPTIONS}")
+file(MAKE_DIRECTORY ${RESULTS_DIR})
+set(NAMES)
+foreach(BENCH ${BENCHMARKS})
+    message(STATUS "running ${BENCH}")
+    set(RESULT_FILE ${RESULTS_DIR}/${BENCH}.json)
+    execute_process(
+        COMMAND ${BENCHMARK_FILE_${BENCH}} --benchmark_out=${RESULT_FILE} --benchmark_out_format=json
+            ${OPTIONS}
+        RESULT_VARIABLE EXIT_CODE)
+    if(NOT EXIT_CODE EQUAL 0)
+        message(FATAL_ERROR "${BENCH} failed: ${EXIT_CODE}")
+    endif()
+
+    file(READ ${RESULT_FILE} JSON)
+    string(JSON COUNT LENGTH "${JSON}" benchmarks)
+    if(COUNT EQUAL 0)
+        continue()
+    endif()
+    math(EXPR LAST "${COUNT} - 1")
+    foreach(INDEX RANGE ${LAST})
+        string(JSON ENTRY GET "${JSON}" benchmarks ${INDEX})
+        string(JSON NAME GET "${ENTRY}" run_name)
+        # such as BM_SmallBatch/16/real_time/threads:1, which can't be part of a variable name
+        string(MAKE_C_IDENTIFIER "${NAME}" KEY)
+        string(JSON RUN_TYPE GET "${ENTRY}" run_type)
+        string(JSON ERROR ERROR_VARIABLE NO_ERROR GET "${ENTRY}" error_occurred)
+        if(ERROR)
+            continue()
+        endif()
+        # with --benchmark_repetitions the median stands for the repetitions
+        if(RUN_TYPE STREQUAL "aggregate")
+            string(JSON AGGREGATE GET "${ENTRY}" aggregate_name)
+            if(NOT AGGREGATE STREQUAL "median")
+                continue()
+            endif()
+        elseif(DEFINED TIME_${BENCH}_${KEY})
+            continue()
+        endif()
+        string(JSON REAL_TIME GET "${ENTRY}" real_time)
+        string(JSON TIME_UNIT GET "${ENTRY}" time_unit)
+        time_to_ps(${REAL_TIME} ${TIME_UNIT} TIME_${BENCH}_${KEY})
+        list(FIND NAMES "${NAME}" FOUND)
+        if(FOUND EQUAL -1)
+            list(APPEND NAMES ${NAME})
+        endif()
+    endforeach()
+endforeach()
+
+# real time of every allocator, and its ratio to the first one, the system allocator
+list(GET BENCHMARKS 0 BASE)
+set(NAME_WIDTH 9)
+foreach(NAME ${NAMES})
+    string(LENGTH "${NAME}" LENGTH)
+    if(LENGTH GREATER NAME_WIDTH)
+        set(NAME_WIDTH ${LENGTH})
+    endif()
+endforeach()
+pad_right("benchmark" ${NAME_WIDTH} HEADER)
+foreach(BENCH ${BENCHMARKS})
+    string(REPLACE "bench_allocator_" "" ALLOCATOR ${BENCH})
+    pad_left(${ALLOCATOR} 20 CELL)
+    string(APPEND HEADER "  ${CELL}")
+endforeach()
+message("\n${HEADER}")
+foreach(NAME ${NAMES})
+    string(MAKE_C_IDENTIFIER "${NAME}" KEY)
+    pad_right("${NAME}" ${NAME_WIDTH} LINE)
+    foreach(BENCH ${BENCHMARKS})
+        set(TIME "${TIME_${BENCH}_${KEY}}")
+        set(BASE_TIME "${TIME_${BASE}_${KEY}}")
+        if(TIME STREQUAL "")
+            set(CELL "n/a")
+        else()
+            format_ps(${TIME} CELL)
+            if(NOT BENCH STREQUAL BASE AND BASE_TIME GREATER 0)
+                math(EXPR RATIO "${TIME} * 100 / ${BASE_TIME}")
+                math(EXPR RATIO_WHOLE "${RATIO} / 100")
+                math(EXPR RATIO_HUNDREDTHS "${RATIO} % 100")
+                if(RATIO_HUNDREDTHS LESS 10)
+                    set(RATIO_HUNDREDTHS "0${RATIO_HUNDREDTHS}")
+                endif()
+                set(CELL "${CELL} (${RATIO_WHOLE}.${RATIO_HUNDREDTHS}x)")
+            endif()
+        endif()
+        pad_left("${CELL}" 20 CELL)
+        string(APPEND LINE "  ${CELL}")
+    endforeach()
+    message("${LINE}")
+endforeach()
+message("\nthe ratios are to the system allocator, below 1.00x is faster, the results are kept in ${RESULTS_DIR}")
+)==");
+
+    EmitFile(ctx, "bench/bench_example.cpp", R"(#include <benchmark/benchmark.h>
+#include "alloc_counter.h"
+static bool isPrime(int n)
+{
+    if (n < 2)
+    {
+        return false;
+    }
+    for (int i = 2; i * i <= n; ++i)
+    {
+        if (n % i == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int findPrimes(int n)
+{
+    int count = 0;
+    for (int i = 2; i <= n; ++i)
+    {
+        if (isPrime(i))
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+static void BM_findPrimes(benchmark::State &state)
+{
+    {
+        // with -DBENCH_COUNT_ALLOCS=ON it reports allocs/iter and bytes/iter, and NoAllocRegion
+        // fails the benchmark if findPrimes ever allocates
+        AllocCounters allocs(state);
+        for (auto _ : state)
+        {
+            NoAllocRegion no_alloc(state);
+            int n = state.range(0);
+            int count = findPrimes(n);
+            benchmark::DoNotOptimize(count);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// configure with -DBENCH_PERF_COUNTERS=ON to also count the cycles, instructions, cache and
+// branch misses per iteration, run-benchmarks adds their IPC and MPKI to the JSON results
+BENCHMARK(BM_findPrimes)->Range(1, 100000);
+BENCHMARK_MAIN();
+)",
+        FileKind::STARTER);
+
+    if (ctx.verbose)
+        LOGINFO("benchmark example written complete!");
+}
+
+void WriteMachineBench(WriterContext const &ctx)
+{
+    EmitFile(ctx, "bench/machine/CMakeLists.txt", R"(# calibrates the build host: the load latency of every cache level and of DRAM, the streaming
+# bandwidth per thread count and the cache line transfer latency between the pairs of cores
+#     cmake --build <build dir> --target machine-bench
+# writes the summary to MACHINE_BENCH_FILE and the Google Benchmark results next to it
+add_executable(machine_bench machine_bench.cpp)
+target_link_libraries(machine_bench PRIVATE benchmark Threads::Threads)
+
+get_filename_component(MACHINE_BENCH_DIR ${MACHINE_BENCH_FILE} DIRECTORY)
+get_filename_component(MACHINE_BENCH_NAME ${MACHINE_BENCH_FILE} NAME_WE)
+add_custom_target(machine-bench
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${MACHINE_BENCH_DIR}
+    COMMAND machine_bench
+        --benchmark_out=${MACHINE_BENCH_DIR}/${MACHINE_BENCH_NAME}.benchmarks.json
+        --benchmark_out_format=json
+        --machine_out=${MACHINE_BENCH_FILE}
+    DEPENDS machine_bench
+    USES_TERMINAL
+    VERBATIM)
+)",
+        FileKind::STARTER);
+
+    EmitFile(ctx, "bench/machine/machine_bench.cpp", R"(// calibrates the memory hierarchy and the core-to-core latency of the host, the benchmarks are
+//     latency/<bytes>            a random pointer chase over a working set of that size
+//     bandwidth_<op>/threads:<n> streaming read, write and copy, each thread on its own buffer
+//     core_to_core/<a>/<b>       two threads pinned on CPUs a and b passing a cache line
+// --machine_out=<file> writes the summary of the results as JSON
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+
+const std::size_t kCacheLine = 64;
+
+// std::vector doesn't align beyond alignof(std::max_align_t)
+class AlignedBuffer
+{
+public:
+    explicit AlignedBuffer(std::size_t size) : storage(size + kCacheLine)
+    {
+        auto address = reinterpret_cast<std::uintptr_t>(storage.data());
+        data = storage.data() + (kCacheLine - address % kCacheLine) % kCacheLine;
+    }
+
+    char *data;
+
+private:
+    std::vector<char> storage;
+};
+
+// well beyond the last level cache, so the largest working sets measure DRAM
+std::size_t LargestWorkingSet()
+{
+    std::size_t last_level = 0;
+    for (auto const &cache : benchmark::CPUInfo::Get().caches)
+    {
+        last_level = std::max(last_level, static_cast<std::size_t>(cache.size));
+    }
+    return std::min(std::max(last_level * 4, std::size_t(64) << 20), std::size_t(1) << 30);
+}
+
+// every cache line of the working set points to the next one of a single random cycle, so
+// neither the prefetchers nor the out-of-order core hide the latency of a load
+void BM_Latency(benchmark::State &state)
+{
+    const int kLoadsPerIteration = 256;
+    std::size_t size = static_cast<std::size_t>(state.range(0));
+    std::size_t lines = size / kCacheLine;
+    AlignedBuffer buffer(size);
+
+    // Sattolo's shuffle, line i points to line next[i]
+    std::vector<std::size_t> next(lines);
+    for (std::size_t i = 0; i < lines; ++i)
+    {
+        next[i] = i;
+    }
+    std::mt19937_64 random(lines);
+    for (std::size_t i = lines - 1; i > 0; --i)
+    {
+        std::uniform_int_distribution<std::size_t> pick(0, i - 1);
+        std::swap(next[i], next[pick(random)]);
+    }
+    for (std::size_t i = 0; i < lines; ++i)
+    {
+        *reinterpret_cast<void **>(buffer.data + i * kCacheLine) = buffer.data + next[i] * kCacheLine;
+    }
+
+    void *line = buffer.data;
+    for (auto _ : state)
+    {
+        for (int i = 0; i < kLoadsPerIteration; ++i)
+        {
+            line = *static_cast<void **>(line);
+        }
+        benchmark::DoNotOptimize(line);
+    }
+    state.counters["latency"] = benchmark::Counter(kLoadsPerIteration,
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+void BM_Read(benchmark::State &state)
+{
+    std::size_t size = LargestWorkingSet() / state.threads();
+    AlignedBuffer buffer(size);
+    auto const *words = reinterpret_cast<std::uint64_t const *>(buffer.data);
+    std::size_t count = size / sizeof(std::uint64_t);
+    for (auto _ : state)
+    {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            sum += words[i];
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * size));
+}
+
+void BM_Write(benchmark::State &state)
+{
+    std::size_t size = LargestWorkingSet() / state.threads();
+    AlignedBuffer buffer(size);
+    int value = 0;
+    for (auto _ : state)
+    {
+        std::memset(buffer.data, ++value, size);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * size));
+}
+
+// counts the bytes read and the bytes written, as STREAM does
+void BM_Copy(benchmark::State &state)
+{
+    std::size_t size = LargestWorkingSet() / state.threads() / 2;
+    AlignedBuffer from(size), to(size);
+    for (auto _ : state)
+    {
+        std::memcpy(to.data, from.data, size);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * size * 2));
+}
+
+#ifdef __linux__
+// the cache line the two threads of BM_CoreToCore pass back and forth
+struct alignas(64) Baton
+{
+    std::atomic<int> holder;
+};
+Baton baton;
+
+// thread 0 waits for the baton and hands it to thread 1, which hands it back, every iteration
+// is a round trip of the cache line between the two CPUs
+void BM_CoreToCore(benchmark::State &state)
+{
+    int self = state.thread_index();
+    cpu_set_t original, pinned;
+    pthread_getaffinity_np(pthread_self(), sizeof(original), &original);
+    CPU_ZERO(&pinned);
+    CPU_SET(static_cast<int>(state.range(self)), &pinned);
+    pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned);
+    if (self == 0)
+    {
+        baton.holder.store(0);
+    }
+
+    for (auto _ : state)
+    {
+        while (baton.holder.load(std::memory_order_acquire) != self)
+        {
+        }
+        baton.holder.store(1 - self, std::memory_order_release);
+    }
+
+    // thread 0 runs on the main thread, which would pin every later benchmark
+    pthread_setaffinity_np(pthread_self(), sizeof(original), &original);
+    if (self == 0)
+    {
+        state.counters["one_way_latency"] = benchmark::Counter(2 * state.iterations(),
+            benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    }
+}
+#endif
+
+std::vector<int> AllowedCpus()
+{
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &allowed))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+void RegisterMachineBenchmarks()
+{
+    auto largest = static_cast<std::int64_t>(LargestWorkingSet());
+    auto *latency = benchmark::RegisterBenchmark("latency", BM_Latency)->UseRealTime();
+    for (std::int64_t size = 4 << 10; size <= largest; size *= 2)
+    {
+        latency->Arg(size);
+        if (size * 3 / 2 <= largest)
+        {
+            latency->Arg(size * 3 / 2);
+        }
+    }
+
+    auto cpus = AllowedCpus();
+    int threads = cpus.empty() ? static_cast<int>(std::thread::hardware_concurrency())
+                               : static_cast<int>(cpus.size());
+    threads = std::max(threads, 1);
+    auto *read = benchmark::RegisterBenchmark("bandwidth_read", BM_Read)->UseRealTime();
+    auto *write = benchmark::RegisterBenchmark("bandwidth_write", BM_Write)->UseRealTime();
+    auto *copy = benchmark::RegisterBenchmark("bandwidth_copy", BM_Copy)->UseRealTime();
+    for (int n = 1; n < threads; n *= 2)
+    {
+        read->Threads(n);
+        write->Threads(n);
+        copy->Threads(n);
+    }
+    read->Threads(threads);
+    write->Threads(threads);
+    copy->Threads(threads);
+
+#ifdef __linux__
+    // every pair on small hosts, CPU 0 against the others on large ones
+    if (cpus.size() >= 2)
+    {
+        auto *core_to_core = benchmark::RegisterBenchmark("core_to_core", BM_CoreToCore)
+                                 ->Threads(2)
+                                 ->UseRealTime()
+                                 ->MinTime(0.2);
+        for (std::size_t a = 0; a < cpus.size(); ++a)
+        {
+            for (std::size_t b = a + 1; b < cpus.size(); ++b)
+            {
+                if (cpus.size() <= 16 || a == 0)
+                {
+                    core_to_core->Args({cpus[a], cpus[b]});
+                }
+            }
+        }
+    }
+#endif
+}
+
+// keeps the best result of every benchmark for the summary while the console shows them
+class SummaryReporter : public benchmark::ConsoleReporter
+{
+public:
+    void ReportRuns(std::vector<Run> const &runs) override
+    {
+        for (auto const &run : runs)
+        {
+            if (run.run_type != Run::RT_Iteration)
+            {
+                continue;
+            }
+            auto const &name = run.run_name.function_name;
+            if (name == "latency" && run.counters.count("latency"))
+            {
+                Keep(latency_ns[std::stoll(run.run_name.args)], run.counters.at("latency") * 1e9,
+                    false);
+            }
+            else if (name.compare(0, 10, "bandwidth_") == 0 && run.counters.count("bytes_per_second"))
+            {
+                Keep(bandwidth_gb_per_s[name.substr(10)][run.threads],
+                    run.counters.at("bytes_per_second") / 1e9, true);
+            }
+            else if (name == "core_to_core" && run.counters.count("one_way_latency"))
+            {
+                Keep(core_to_core_ns[run.run_name.args], run.counters.at("one_way_latency") * 1e9,
+                    false);
+            }
+        }
+        ConsoleReporter::ReportRuns(runs);
+    }
+
+    std::map<std::int64_t, double> latency_ns;
+    std::map<std::string, std::map<int, double>> bandwidth_gb_per_s;
+    std::map<std::string, double> core_to_core_ns;
+
+private:
+    // the best of the repetitions, 0 stands for no result yet
+    static void Keep(double &best, double value, bool higher_is_better)
+    {
+        if (best == 0 || (higher_is_better ? value > best : value < best))
+        {
+            best = value;
+        }
+    }
+};
+
+std::string Number(double value)
+{
+    std::ostringstream out;
+    out.precision(4);
+    out << value;
+    return out.str();
+}
+
+// the latency of a cache level is the one of the largest working set filling at most half of it
+void WriteSummary(std::string const &path, SummaryReporter const &results)
+{
+    std::ostringstream json;
+    auto const &cpu = benchmark::CPUInfo::Get();
+    json << "{\n    \"host_name\": \"" << benchmark::SystemInfo::Get().name << "\",\n"
+         << "    \"num_cpus\": " << cpu.num_cpus << ",\n"
+         << "    \"mhz_per_cpu\": " << Number(cpu.cycles_per_second / 1e6) << ",\n";
+
+    std::map<std::string, std::int64_t> cache_sizes;
+    for (auto const &cache : cpu.caches)
+    {
+        if (cache.type != "Instruction")
+        {
+            cache_sizes.insert(std::make_pair("L" + std::to_string(cache.level), cache.size));
+        }
+    }
+    json << "    \"cache_bytes\": {";
+    std::string separator;
+    for (auto const &cache : cache_sizes)
+    {
+        json << separator << "\"" << cache.first << "\": " << cache.second;
+        separator = ", ";
+    }
+    json << "},\n    \"latency_ns\": {";
+    separator.clear();
+    for (auto const &cache : cache_sizes)
+    {
+        double latency = 0;
+        for (auto const &point : results.latency_ns)
+        {
+            if (point.first * 2 <= cache.second)
+            {
+                latency = point.second;
+            }
+        }
+        if (latency > 0)
+        {
+            json << separator << "\"" << cache.first << "\": " << Number(latency);
+            separator = ", ";
+        }
+    }
+    if (!results.latency_ns.empty())
+    {
+        json << separator << "\"DRAM\": " << Number(results.latency_ns.rbegin()->second);
+    }
+    json << "},\n    \"latency_sweep_ns\": {";
+    separator.clear();
+    for (auto const &point : results.latency_ns)
+    {
+        json << separator << "\"" << point.first << "\": " << Number(point.second);
+        separator = ", ";
+    }
+    json << "},\n    \"bandwidth_gb_per_s\": {";
+    separator.clear();
+    for (auto const &op : results.bandwidth_gb_per_s)
+    {
+        json << separator << "\"" << op.first << "\": {";
+        std::string threads_separator;
+        for (auto const &threads : op.second)
+        {
+            json << threads_separator << "\"" << threads.first << "\": " << Number(threads.second);
+            threads_separator = ", ";
+        }
+        json << "}";
+        separator = ", ";
+    }
+    json << "},\n    \"core_to_core_ns\": {";
+    if (!results.core_to_core_ns.empty())
+    {
+        std::vector<double> latencies;
+        for (auto const &pair : results.core_to_core_ns)
+        {
+            latencies.push_back(pair.second);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        json << "\"min\": " << Number(latencies.front())
+             << ", \"median\": " << Number(latencies[latencies.size() / 2])
+             << ", \"max\": " << Number(latencies.back()) << ", \"pairs\": {";
+        separator.clear();
+        for (auto const &pair : results.core_to_core_ns)
+        {
+            json << separator << "\"" << pair.first << "\": " << Number(pair.second);
+            separator = ", ";
+        }
+        json << "}";
+    }
+    json << "}\n}\n";
+
+    std::ofstream file(path);
+    file << json.str();
+    if (!file)
+    {
+        std::cerr << "failed to write " << path << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+    // Google Benchmark has taken its flags out of argv, the rest must be ours
+    std::string summary_path;
+    int kept = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 14, "--machine_out=") == 0)
+        {
+            summary_path = arg.substr(14);
+        }
+        else
+        {
+            argv[kept++] = argv[i];
+        }
+    }
+    if (benchmark::ReportUnrecognizedArguments(kept, argv))
+    {
+        return 1;
+    }
+
+    RegisterMachineBenchmarks();
+    SummaryReporter results;
+    benchmark::RunSpecifiedBenchmarks(&results);
+    if (!summary_path.empty())
+    {
+        WriteSummary(summary_path, results);
+        std::cout << "summary written to " << summary_path << "\n";
+    }
+    return 0;
+}
 )",
-        upper_name, ctx.repo_name);
-
-    cmakelist << "# edit the following settings as you desire\n"
-              << fmt::format("set(CMAKE_CXX_STANDARD {})\n", ctx.cxx_std)
-              << "set(CMAKE_CXX_STANDARD_REQUIRED ON)\n"
-              << "set(CMAKE_CXX_STANDARD_EXTENSION OFF)\n"
-              << "add_compile_options(-Wfatal-errors)\n\n";
-    cmakelist << "# edit the following line to add your cmake modules\n"
-              << "list(APPEND CMAKE_MODULE_PATH ${PROJECT_SOURCE_DIR}/cmake_modules)\n";
-    cmakelist << "# edit the following line to add your dependencies\n"
-              << "find_package(Threads REQUIRED)\n\n";
-    // for executable repo, scan the 'repo_name' dir to add all cpp files as it's SRCS
-    cmakelist << "# Please note, CMake does not recommend GLOB to collect a list of source files "
-                 "from your source tree.\n"
-              << "# Any new files added to your source tree won't be noticed by CMake until you "
-                 "rerun CMake manually.\n";
-    if (RepoType::EXECUTABLE == ctx.repo_type)
+        FileKind::STARTER);
+}
+
+void WriteSimdKernels(WriterContext const &ctx)
+{
+    EmitFile(ctx, "simd/CMakeLists.txt", R"(# kernels.cpp is compiled once per x86-64 ISA level into the object library simd_<level>, and
+# dispatch.cpp binds the kernels to the best level the CPU supports at their first call, so one
+# binary runs at full speed on every host, where a -march=native build crashes on the older ones.
+# The root CMakeLists.txt links SIMD_OBJECT_LIBRARIES into the main target, the unit tests and the
+# benchmarks.
+include(CheckCXXCompilerFlag)
+set(SIMD_LEVELS baseline)
+set(SIMD_FLAGS_baseline)
+if(CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64|amd64)$")
+    list(APPEND SIMD_LEVELS sse42 avx2 avx512)
+    if(MSVC)
+        # no switch for SSE4.2, its intrinsics are always available
+        set(SIMD_FLAGS_sse42)
+        set(SIMD_FLAGS_avx2 /arch:AVX2)
+        set(SIMD_FLAGS_avx512 /arch:AVX512)
+    else()
+        # every level starts from the x86-64 baseline, whatever -march the rest of the build uses
+        set(SIMD_FLAGS_baseline -march=x86-64)
+        set(SIMD_FLAGS_sse42 ${SIMD_FLAGS_baseline} -msse4.2 -mpopcnt)
+        set(SIMD_FLAGS_avx2 ${SIMD_FLAGS_sse42} -mavx2 -mfma -mbmi -mbmi2)
+        # gcc keeps to 256-bit vectors for AVX-512 unless told otherwise
+        set(SIMD_FLAGS_avx512 ${SIMD_FLAGS_avx2} -mavx512f -mavx512bw -mavx512dq -mavx512vl
+            -mprefer-vector-width=512)
+    endif()
+endif()
+
+set(SIMD_OBJECT_LIBRARIES)
+set(SIMD_DEFINITIONS)
+foreach(SIMD_LEVEL ${SIMD_LEVELS})
+    set(SIMD_LEVEL_SUPPORTED ON)
+    foreach(SIMD_FLAG ${SIMD_FLAGS_${SIMD_LEVEL}})
+        string(MAKE_C_IDENTIFIER "CXX_HAS${SIMD_FLAG}" SIMD_FLAG_VARIABLE)
+        check_cxx_compiler_flag(${SIMD_FLAG} ${SIMD_FLAG_VARIABLE})
+        if(NOT ${SIMD_FLAG_VARIABLE})
+            set(SIMD_LEVEL_SUPPORTED OFF)
+        endif()
+    endforeach()
+    if(NOT SIMD_LEVEL_SUPPORTED)
+        message(STATUS "simd: the compiler can't build the ${SIMD_LEVEL} kernels, skipped")
+        continue()
+    endif()
+    add_library(simd_${SIMD_LEVEL} OBJECT kernels.cpp)
+    target_compile_definitions(simd_${SIMD_LEVEL} PRIVATE SIMD_LEVEL=${SIMD_LEVEL})
+    target_compile_options(simd_${SIMD_LEVEL} PRIVATE ${SIMD_FLAGS_${SIMD_LEVEL}})
+    set_target_properties(simd_${SIMD_LEVEL} PROPERTIES POSITION_INDEPENDENT_CODE ON)
+    string(TOUPPER ${SIMD_LEVEL} SIMD_LEVEL_UPPER)
+    list(APPEND SIMD_DEFINITIONS SIMD_HAS_${SIMD_LEVEL_UPPER})
+    list(APPEND SIMD_OBJECT_LIBRARIES simd_${SIMD_LEVEL})
+endforeach()
+message(STATUS "simd: kernels built for ${SIMD_OBJECT_LIBRARIES}")
+
+# compiled for the baseline, as it runs before any level is known to be supported
+add_library(simd_dispatch OBJECT dispatch.cpp)
+target_compile_definitions(simd_dispatch PRIVATE ${SIMD_DEFINITIONS})
+target_compile_options(simd_dispatch PRIVATE ${SIMD_FLAGS_baseline})
+target_include_directories(simd_dispatch PUBLIC ${CMAKE_CURRENT_SOURCE_DIR})
+set_target_properties(simd_dispatch PROPERTIES POSITION_INDEPENDENT_CODE ON)
+list(APPEND SIMD_OBJECT_LIBRARIES simd_dispatch)
+set(SIMD_OBJECT_LIBRARIES ${SIMD_OBJECT_LIBRARIES} PARENT_SCOPE)
+
+# the dispatcher and the baseline kernels crash on the older hosts when a flag raises their ISA,
+# such as -mavx2 in CMAKE_CXX_FLAGS or an -march given after the baseline one
+if(CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64|amd64)$")
+    set(SIMD_COMMON_FLAGS ${CMAKE_CXX_FLAGS})
+    foreach(SIMD_CONFIG ${CMAKE_BUILD_TYPE} ${CMAKE_CONFIGURATION_TYPES})
+        string(TOUPPER ${SIMD_CONFIG} SIMD_CONFIG)
+        list(APPEND SIMD_COMMON_FLAGS ${CMAKE_CXX_FLAGS_${SIMD_CONFIG}})
+    endforeach()
+    foreach(SIMD_TARGET simd_dispatch simd_baseline)
+        get_target_property(SIMD_TARGET_OPTIONS ${SIMD_TARGET} COMPILE_OPTIONS)
+        string(JOIN " " SIMD_TARGET_FLAGS ${SIMD_COMMON_FLAGS} ${SIMD_TARGET_OPTIONS})
+        string(REGEX MATCHALL "-march=[^ ;>]+" SIMD_MARCH_FLAGS "${SIMD_TARGET_FLAGS}")
+        list(POP_BACK SIMD_MARCH_FLAGS SIMD_LAST_MARCH_FLAG)
+        string(REGEX MATCH "(-m(sse3|ssse3|sse4|avx|fma|bmi|popcnt|f16c|lzcnt|movbe)|/arch:AVX)[^ ;>]*"
+            SIMD_RAISING_FLAG "${SIMD_TARGET_FLAGS}")
+        if(SIMD_LAST_MARCH_FLAG AND NOT SIMD_LAST_MARCH_FLAG STREQUAL "-march=x86-64")
+            set(SIMD_RAISING_FLAG ${SIMD_LAST_MARCH_FLAG})
+        endif()
+        if(SIMD_RAISING_FLAG)
+            message(FATAL_ERROR "simd: ${SIMD_TARGET} must run on any x86-64 host, but is compiled with ${SIMD_RAISING_FLAG}")
+        endif()
+    endforeach()
+endif()
+)", FileKind::STARTER);
+
+    EmitFile(ctx, "simd/simd_kernels.h", R"(#pragma once
+// kernels bound at runtime to the best x86-64 ISA level the CPU supports, see dispatch.cpp
+// adding a kernel: declare it in kernel_levels.h, write it in kernels.cpp, then add it to Kernels
+// below and to the levels table of dispatch.cpp
+#include <cstddef>
+#include <cstdint>
+
+namespace simd
+{
+
+// the ISA levels the kernels are compiled for, in the order of preference
+enum class Isa
+{
+    BASELINE, // the default target of the compiler, SSE2 on x86-64
+    SSE42,    // with POPCNT, as x86-64-v2
+    AVX2,     // with FMA, BMI and BMI2, as x86-64-v3
+    AVX512,   // F, BW, DQ and VL, as x86-64-v4
+};
+
+// y[i] = a * x[i] + y[i]
+void Saxpy(float a, float const *x, float *y, std::size_t n);
+
+// the sum of the n bytes of data
+uint64_t SumBytes(uint8_t const *data, std::size_t n);
+
+// the kernels of one ISA level
+struct Kernels
+{
+    Isa isa;
+    void (*saxpy)(float a, float const *x, float *y, std::size_t n);
+    uint64_t (*sum_bytes)(uint8_t const *data, std::size_t n);
+};
+
+// the kernels of isa, nullptr if they are not built or the CPU can't run them, for the unit
+// tests and the benchmarks comparing the levels
+Kernels const *KernelsFor(Isa isa);
+
+// the level the kernels above are bound to
+Isa ActiveIsa();
+
+// such as "avx2"
+char const *IsaName(Isa isa);
+
+} // namespace simd
+)", FileKind::STARTER);
+
+    EmitFile(ctx, "simd/kernel_levels.h", R"(#pragma once
+// the kernels of every ISA level, kernels.cpp defines the ones of the level it is compiled for
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86_64 1
+#endif
+
+#define SIMD_DECLARE_LEVEL(level)                                                                  \
+    namespace simd                                                                                 \
+    {                                                                                              \
+    namespace level                                                                                \
+    {                                                                                              \
+    void Saxpy(float a, float const *x, float *y, std::size_t n);                                  \
+    uint64_t SumBytes(uint8_t const *data, std::size_t n);                                         \
+    }                                                                                              \
+    }
+
+SIMD_DECLARE_LEVEL(baseline)
+SIMD_DECLARE_LEVEL(sse42)
+SIMD_DECLARE_LEVEL(avx2)
+SIMD_DECLARE_LEVEL(avx512)
+)", FileKind::STARTER);
+
+    EmitFile(ctx, "simd/kernels.cpp", R"(// the kernels of one ISA level, simd/CMakeLists.txt compiles this file once per level with
+// SIMD_LEVEL naming the level and the flags of the level, such as -mavx2 -mfma for avx2. The plain
+// loops are vectorized by the compiler for the level, the intrinsics take the widest path the
+// flags allow, as told by the macros they define, such as __AVX2__.
+// Call no inline function or template which other files use as well, such as the ones of
+// <algorithm> or <vector>: the linker keeps a single copy of them, which may be the avx512 one,
+// and the baseline code calling it would then crash on the hosts without AVX-512.
+#include "kernel_levels.h"
+#ifdef SIMD_X86_64
+#include <immintrin.h>
+#endif
+
+namespace simd
+{
+namespace SIMD_LEVEL
+{
+
+void Saxpy(float a, float const *x, float *y, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        y[i] = a * x[i] + y[i];
+    }
+}
+
+uint64_t SumBytes(uint8_t const *data, std::size_t n)
+{
+    uint64_t sum = 0;
+    std::size_t i = 0;
+    // psadbw against zero sums every 8 bytes into a 64-bit lane
+#if defined(SIMD_X86_64) && defined(__AVX512BW__)
+    __m512i zero = _mm512_setzero_si512(), sums = zero;
+    for (; i + 64 <= n; i += 64)
+    {
+        sums = _mm512_add_epi64(sums, _mm512_sad_epu8(_mm512_loadu_si512(data + i), zero));
+    }
+    sum = static_cast<uint64_t>(_mm512_reduce_add_epi64(sums));
+#elif defined(SIMD_X86_64) && defined(__AVX2__)
+    __m256i zero = _mm256_setzero_si256(), sums = zero;
+    for (; i + 32 <= n; i += 32)
+    {
+        auto bytes = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data + i));
+        sums = _mm256_add_epi64(sums, _mm256_sad_epu8(bytes, zero));
+    }
+    __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    sum = static_cast<uint64_t>(_mm_cvtsi128_si64(half) + _mm_extract_epi64(half, 1));
+#elif defined(SIMD_X86_64)
+    __m128i zero = _mm_setzero_si128(), sums = zero;
+    for (; i + 16 <= n; i += 16)
     {
-        cmakelist << fmt::format("file(GLOB_RECURSE EXECUTABLE_SRC \"{}/*.cpp\")\n", ctx.repo_name)
-                  << "add_executable(${PROJECT_NAME} ${EXECUTABLE_SRC})\n";
-        cmakelist << "target_include_directories(${PROJECT_NAME} PRIVATE\n    "
-                  << fmt::format("${{PROJECT_SOURCE_DIR}}/{})\n\n", ctx.repo_name);
+        auto bytes = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i));
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(bytes, zero));
     }
-    else // for library repo, scan the 'src' dir to add all cpp files as it's SRCS
+    sum = static_cast<uint64_t>(
+        _mm_cvtsi128_si64(sums) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums)));
+#endif
+    for (; i < n; ++i)
     {
-        cmakelist << fmt::format("file(GLOB_RECURSE LIBRARY_SRC \"{}/*.cpp\")\n", ctx.repo_name)
-                  << "add_library(${PROJECT_NAME} "
-                  << (ctx.repo_type == RepoType::SHARED ? "SHARED" : "STATIC")
-                  << " \"${LIBRARY_SRC}\")\n";
-        cmakelist << "# you may add more dependencies' header dir here\n";
-        cmakelist << "target_include_directories(${PROJECT_NAME}\n"
-                  << "    PUBLIC\n"
-                  << "        $<BUILD_INTERFACE:${PROJECT_SOURCE_DIR}/" << ctx.repo_name << ">\n"
-                  << "        $<INSTALL_INTERFACE:" << ctx.repo_name << ">\n"
-                  << "    PRIVATE\n"
-                  << "        ${PROJECT_SOURCE_DIR}/src)\n\n";
+        sum += data[i];
     }
+    return sum;
+}
 
-    // link example
-    cmakelist << R"(# edit the following line to link your dependencies libraries
-target_link_libraries(${PROJECT_NAME}
-    PRIVATE
-        Threads::Threads)
-)";
+} // namespace SIMD_LEVEL
+} // namespace simd
+)", FileKind::STARTER);
+
+    EmitFile(ctx, "simd/dispatch.cpp", R"(// binds the kernels to the best ISA level the CPU and the OS support, once, at the first call of
+// any of them. SIMD_HAS_<LEVEL> tells the levels simd/CMakeLists.txt could build, and the
+// environment variable SIMD_MAX_ISA=baseline|sse42|avx2|avx512 caps the level, such as to
+// reproduce the behavior of an older host.
+#include "simd_kernels.h"
+#include "kernel_levels.h"
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#ifdef SIMD_X86_64
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace simd
+{
 
-    // install
-    cmakelist << fmt::format(R"(# install settings
-include(GNUInstallDirs)
-install(TARGETS ${{PROJECT_NAME}}
-    EXPORT {}_EXPORT
-    RUNTIME DESTINATION ${{CMAKE_INSTALL_BINDIR}}
-    LIBRARY DESTINATION ${{CMAKE_INSTALL_LIBDIR}}
-    ARCHIVE DESTINATION ${{CMAKE_INSTALL_LIBDIR}})
-)",
-        upper_name);
+// the levels built into the binary, constant initialized, so the kernels may run before main
+static const Kernels levels[] = {
+    {Isa::BASELINE, baseline::Saxpy, baseline::SumBytes},
+#ifdef SIMD_HAS_SSE42
+    {Isa::SSE42, sse42::Saxpy, sse42::SumBytes},
+#endif
+#ifdef SIMD_HAS_AVX2
+    {Isa::AVX2, avx2::Saxpy, avx2::SumBytes},
+#endif
+#ifdef SIMD_HAS_AVX512
+    {Isa::AVX512, avx512::Saxpy, avx512::SumBytes},
+#endif
+};
+
+#ifdef SIMD_X86_64
+struct CpuidRegs
+{
+    uint32_t eax, ebx, ecx, edx;
+};
 
-    // install public headers if it's library repo
-    if (RepoType::EXECUTABLE != ctx.repo_type)
+static CpuidRegs Cpuid(uint32_t leaf, uint32_t subleaf)
+{
+    CpuidRegs regs = {0, 0, 0, 0};
+#ifdef _MSC_VER
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    regs = {static_cast<uint32_t>(out[0]), static_cast<uint32_t>(out[1]),
+        static_cast<uint32_t>(out[2]), static_cast<uint32_t>(out[3])};
+#else
+    if (leaf <= __get_cpuid_max(0, nullptr))
     {
-        cmakelist << fmt::format(R"(# install public headers
-set(PUBLIC_HEADER_DIR ${{PROJECT_SOURCE_DIR}}/{})
-install(DIRECTORY ${{PUBLIC_HEADER_DIR}}
-    DESTINATION ${{CMAKE_INSTALL_INCLUDEDIR}}
-    FILES_MATCHING
-        PATTERN "*.h"
-        PATTERN "*.hpp")
-)",
-            ctx.repo_name);
+        __cpuid_count(leaf, subleaf, regs.eax, regs.ebx, regs.ecx, regs.edx);
     }
+#endif
+    return regs;
+}
 
-    // export cmake config
-    cmakelist << fmt::format(R"(install(EXPORT {0}_EXPORT
-    FILE {1}-config.cmake
-    NAMESPACE {1}::
-    DESTINATION cmake)
-    include(CMakePackageConfigHelpers)
-write_basic_package_version_file(
-    "{1}-config-version.cmake"
-    COMPATIBILITY SameMajorVersion)
-install(FILES
-    "${{CMAKE_CURRENT_BINARY_DIR}}/{1}-config-version.cmake"
-    DESTINATION cmake)
-)",
-        upper_name, ctx.repo_name);
-
-    // both library and executable repo support versioning
-    cmakelist << fmt::format(
-        R"(message(STATUS "current {0} version: ${{{1}_VERSION_MAJOR}}.${{{1}_VERSION_MINOR}}.${{{1}_VERSION_PATCH}}")
-set(CPACK_PACKAGE_VERSION_MAJOR ${{{1}_VERSION_MAJOR}})
-set(CPACK_PACKAGE_VERSION_MINOR ${{{1}_VERSION_MINOR}})
-set(CPACK_PACKAGE_VERSION_PATCH ${{{1}_VERSION_PATCH}})
-)",
-        ctx.repo_name, upper_name);
-    // cpack settings
-    cmakelist << "# cpack settings, edit the following to pack up as you desire\n";
-    cmakelist << "if(UNIX)\n"
-              << "    set(CPACK_GENERATOR \"TGZ\")\n"
-              << "else()\n"
-              << "    set(CPACK_GENERATOR \"ZIP\")\n"
-              << "endif()\n"
-              << "set(CPACK_PACKAGE_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}/packages)\n"
-              << "include(CPack)\n";
-    LOGINFO("root CMakeLists.txt written complete!");
-}
-
-void WriteUnitTests()
-{
-    std::ofstream unit_test("unit_test/CMakeLists.txt");
-    unit_test << R"(# an easy way to add unit test
-# for now it supports only one src file for each TestCase
-function(add_unit_test CASE_TARGET SOURCE)
-    add_executable(${CASE_TARGET} ${SOURCE})
-    target_link_libraries(${CASE_TARGET}
-        PRIVATE 
-            ${LIBRARIES_FOR_TEST} # put your library here
-            GTest::gtest
-            GTest::gtest_main
-            Threads::Threads)
-    string(TOUPPER ${CASE_TARGET} CASE_TARGET_UPPERCASE)
-    set(CASE_NAME "TEST_${CASE_TARGET_UPPERCASE}")
-    add_test(NAME ${CASE_NAME} COMMAND ${CASE_TARGET})
-endfunction()
+// XCR0, the register states the OS saves on a context switch
+static uint64_t EnabledRegisterStates()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
 
-file(GLOB UNIT_TEST_SRCS "*.cpp")
+static bool Bit(uint32_t reg, int bit)
+{
+    return (reg >> bit) & 1;
+}
+#endif
 
-foreach(TEST_SRC ${UNIT_TEST_SRCS})
-    get_filename_component(BASE_NAME ${TEST_SRC} NAME_WE)
-    add_unit_test(${BASE_NAME} ${TEST_SRC})
-endforeach()
-)";
+static bool CpuSupports(Isa isa)
+{
+#ifdef SIMD_X86_64
+    auto leaf1 = Cpuid(1, 0);
+    auto leaf7 = Cpuid(7, 0);
+    // the vector registers are only usable when the OS saves them, which OSXSAVE and XCR0 tell
+    uint64_t states = Bit(leaf1.ecx, 27) ? EnabledRegisterStates() : 0;
+    bool sse42 = Bit(leaf1.ecx, 20) && Bit(leaf1.ecx, 23);
+    bool avx2 = sse42 && (states & 0x6) == 0x6 && Bit(leaf1.ecx, 28) && Bit(leaf1.ecx, 12) &&
+                Bit(leaf7.ebx, 5) && Bit(leaf7.ebx, 3) && Bit(leaf7.ebx, 8);
+    // plus the opmask and the upper zmm states
+    bool avx512 = avx2 && (states & 0xe6) == 0xe6 && Bit(leaf7.ebx, 16) && Bit(leaf7.ebx, 17) &&
+                  Bit(leaf7.ebx, 30) && Bit(leaf7.ebx, 31);
+    switch (isa)
+    {
+    case Isa::BASELINE:
+        return true;
+    case Isa::SSE42:
+        return sse42;
+    case Isa::AVX2:
+        return avx2;
+    case Isa::AVX512:
+        return avx512;
+    }
+    return false;
+#else
+    return Isa::BASELINE == isa;
+#endif
+}
 
-    std::ofstream unit_test_example("unit_test/example.cpp");
-    unit_test_example << R"(#include <gtest/gtest.h>
-TEST(EXAMPLE, example_case)
+Kernels const *KernelsFor(Isa isa)
 {
-    int i = 1;
-    EXPECT_EQ(i, 1);
-    bool no = false;
-    EXPECT_FALSE(no);
+    for (auto const &kernels : levels)
+    {
+        if (kernels.isa == isa)
+        {
+            return CpuSupports(isa) ? &kernels : nullptr;
+        }
+    }
+    return nullptr;
 }
 
-int main(int argc, char** argv)
+char const *IsaName(Isa isa)
 {
-    ::testing::InitGoogleTest(&argc, argv);
-    return RUN_ALL_TESTS();
+    switch (isa)
+    {
+    case Isa::BASELINE:
+        return "baseline";
+    case Isa::SSE42:
+        return "sse42";
+    case Isa::AVX2:
+        return "avx2";
+    case Isa::AVX512:
+        return "avx512";
+    }
+    return "unknown";
 }
-)";
 
-    LOGINFO("unit_test/CMakeLists.txt written complete!");
+static Kernels const &SelectKernels()
+{
+    Isa max_isa = Isa::AVX512;
+    if (char const *cap = std::getenv("SIMD_MAX_ISA"))
+    {
+        for (auto isa : {Isa::BASELINE, Isa::SSE42, Isa::AVX2, Isa::AVX512})
+        {
+            if (std::strcmp(cap, IsaName(isa)) == 0)
+            {
+                max_isa = isa;
+            }
+        }
+    }
+    Kernels const *best = &levels[0];
+    for (auto const &kernels : levels)
+    {
+        if (kernels.isa <= max_isa && CpuSupports(kernels.isa))
+        {
+            best = &kernels;
+        }
+    }
+    return *best;
 }
 
-void WriteBenchmark()
+// a function local static is initialized once, even when several threads make the first call
+static Kernels const &Active()
 {
-    std::ofstream bench("bench/CMakeLists.txt");
-    bench << R"(function(add_benchmark BENCH_NAME SOURCE)
-    add_executable(${BENCH_NAME} ${SOURCE})
-    target_link_libraries(${BENCH_NAME}
-        PRIVATE
-            benchmark
-            Threads::Threads)
-endfunction()
+    static Kernels const &active = SelectKernels();
+    return active;
+}
 
-add_benchmark(bench_example bench_example.cpp)
-)";
-    std::ofstream bench_example("bench/bench_example.cpp");
-    bench_example << R"(#include <benchmark/benchmark.h>
-static bool isPrime(int n)
+Isa ActiveIsa()
 {
-    if (n < 2)
+    return Active().isa;
+}
+
+void Saxpy(float a, float const *x, float *y, std::size_t n)
+{
+    Active().saxpy(a, x, y, n);
+}
+
+uint64_t SumBytes(uint8_t const *data, std::size_t n)
+{
+    return Active().sum_bytes(data, n);
+}
+
+} // namespace simd
+)", FileKind::STARTER);
+
+    EmitFile(ctx, "unit_test/simd_kernels_test.cpp", R"(#include "simd_kernels.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// every level built into the binary which the CPU can run
+static std::vector<simd::Kernels const *> SupportedLevels()
+{
+    std::vector<simd::Kernels const *> levels;
+    for (auto isa : {simd::Isa::BASELINE, simd::Isa::SSE42, simd::Isa::AVX2, simd::Isa::AVX512})
     {
-        return false;
+        if (auto const *kernels = simd::KernelsFor(isa))
+        {
+            levels.push_back(kernels);
+        }
     }
-    for (int i = 2; i * i <= n; ++i)
+    return levels;
+}
+
+// the scalar references the levels are checked against
+static void ReferenceSaxpy(float a, float const *x, float *y, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
     {
-        if (n % i == 0)
+        y[i] = a * x[i] + y[i];
+    }
+}
+
+static uint64_t ReferenceSumBytes(uint8_t const *data, std::size_t n)
+{
+    uint64_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        sum += data[i];
+    }
+    return sum;
+}
+
+// around the vector widths, so the remainder loops of every level are reached as well
+static const std::size_t sizes[] = {0, 1, 7, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 1000, 4099};
+
+TEST(SIMD, saxpy_matches_reference)
+{
+    for (auto const *kernels : SupportedLevels())
+    {
+        SCOPED_TRACE(simd::IsaName(kernels->isa));
+        for (auto n : sizes)
         {
-            return false;
+            std::vector<float> x(n), y(n);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                x[i] = static_cast<float>(i % 13) * 0.25f - 1.0f;
+                y[i] = static_cast<float>(i % 7) * 0.5f;
+            }
+            auto expected = y;
+            ReferenceSaxpy(1.5f, x.data(), expected.data(), n);
+            kernels->saxpy(1.5f, x.data(), y.data(), n);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                // a fused multiply-add rounds once, the reference twice
+                EXPECT_NEAR(y[i], expected[i], 1e-5f * (1.0f + std::fabs(expected[i])))
+                    << "n = " << n << ", i = " << i;
+            }
         }
     }
-    return true;
 }
 
-static int findPrimes(int n)
+TEST(SIMD, sum_bytes_matches_reference)
 {
-    int count = 0;
-    for (int i = 2; i <= n; ++i)
+    std::vector<uint8_t> data(4099 + 3);
+    for (std::size_t i = 0; i < data.size(); ++i)
     {
-        if (isPrime(i))
+        data[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    for (auto const *kernels : SupportedLevels())
+    {
+        SCOPED_TRACE(simd::IsaName(kernels->isa));
+        for (auto n : sizes)
         {
-            count++;
+            // unaligned starts as well
+            for (std::size_t offset = 0; offset < 4; ++offset)
+            {
+                EXPECT_EQ(kernels->sum_bytes(data.data() + offset, n),
+                    ReferenceSumBytes(data.data() + offset, n))
+                    << "n = " << n << ", offset = " << offset;
+            }
         }
     }
-    return count;
 }
 
-static void BM_findPrimes(benchmark::State &state)
+TEST(SIMD, dispatch_binds_best_level)
+{
+    if (std::getenv("SIMD_MAX_ISA"))
+    {
+        GTEST_SKIP() << "SIMD_MAX_ISA caps the level";
+    }
+    EXPECT_EQ(simd::ActiveIsa(), SupportedLevels().back()->isa);
+    std::vector<uint8_t> data(100, 1);
+    EXPECT_EQ(simd::SumBytes(data.data(), data.size()), 100u);
+}
+)", FileKind::STARTER);
+
+    EmitFile(ctx, "bench/bench_simd.cpp", R"(#include "simd_kernels.h"
+#include <benchmark/benchmark.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// kernels is null for the dispatched kernels, which the active level runs after an indirect call
+static void BM_Saxpy(benchmark::State &state, simd::Kernels const *kernels)
 {
+    auto n = static_cast<std::size_t>(state.range(0));
+    std::vector<float> x(n, 0.5f), y(n, 0.25f);
     for (auto _ : state)
     {
-        int n = state.range(0);
-        int count = findPrimes(n);
-        benchmark::DoNotOptimize(count);
+        if (kernels)
+        {
+            kernels->saxpy(1e-3f, x.data(), y.data(), n);
+        }
+        else
+        {
+            simd::Saxpy(1e-3f, x.data(), y.data(), n);
+        }
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
     }
+    // x and y read, y written
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(3 * n * sizeof(float)));
 }
 
-BENCHMARK(BM_findPrimes)->Range(1, 100000);
-BENCHMARK_MAIN();
-)";
-    LOGINFO("benchmark example written complete!");
+static void BM_SumBytes(benchmark::State &state, simd::Kernels const *kernels)
+{
+    auto n = static_cast<std::size_t>(state.range(0));
+    std::vector<uint8_t> data(n, 3);
+    for (auto _ : state)
+    {
+        auto sum = kernels ? kernels->sum_bytes(data.data(), n) : simd::SumBytes(data.data(), n);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(n));
 }
 
-void WriteSrcAndHeader(WriterContext const &ctx)
+// every kernel at every level the CPU runs, then dispatched, from L1 sized to DRAM sized data
+static void RegisterSimdBenchmarks()
 {
-    std::string upper_name = ToUpper(ctx.repo_name);
-    // src file and header
-    // library repo's repo_name.cpp will be located in 'repo_name' dir
-    auto cppfile_name = fmt::format("{0}/{0}.cpp", ctx.repo_name);
-    std::ofstream cppfile(cppfile_name);
-    if (!cppfile)
+    std::vector<std::pair<std::string, simd::Kernels const *>> variants;
+    for (auto isa : {simd::Isa::BASELINE, simd::Isa::SSE42, simd::Isa::AVX2, simd::Isa::AVX512})
+    {
+        if (auto const *kernels = simd::KernelsFor(isa))
+        {
+            variants.emplace_back(simd::IsaName(isa), kernels);
+        }
+    }
+    variants.emplace_back("dispatched", nullptr);
+    for (auto const &variant : variants)
+    {
+        benchmark::RegisterBenchmark(
+            ("BM_Saxpy/" + variant.first).c_str(), BM_Saxpy, variant.second)
+            ->RangeMultiplier(16)
+            ->Range(1 << 10, 1 << 22);
+        benchmark::RegisterBenchmark(
+            ("BM_SumBytes/" + variant.first).c_str(), BM_SumBytes, variant.second)
+            ->RangeMultiplier(16)
+            ->Range(1 << 12, 1 << 24);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    RegisterSimdBenchmarks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
     {
-        LOGERR("failed to open file: {}", cppfile_name);
+        return 1;
     }
-    cppfile << fmt::format(R"(#include "{1}.h"
+    std::cout << "kernels dispatched to " << simd::IsaName(simd::ActiveIsa()) << "\n";
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
+)", FileKind::STARTER);
+}
+
+void WriteSrcAndHeader(WriterContext const &ctx)
+{
+    // library repo's repo_name.cpp will be located in 'repo_name' dir
+    static const Template cppfile(R"(#include "{{repo_name}}.h"
+// defined by the TARGET_ISA option of CMakeLists.txt
+#ifndef {{REPO_NAME}}_TARGET_ISA
+#define {{REPO_NAME}}_TARGET_ISA "baseline"
+#endif
+// such as "0.0.1+x86-64-v3", the instruction set the binary requires as the build metadata
 const char *GetVersionString()
-{{
+{
 #define XX(x) #x
 #define STRINGIFY(x) XX(x)
-    return STRINGIFY({0}_VERSION_MAJOR.{0}_VERSION_MINOR.{0}_VERSION_PATCH);
+    return STRINGIFY({{REPO_NAME}}_VERSION_MAJOR.{{REPO_NAME}}_VERSION_MINOR.{{REPO_NAME}}_VERSION_PATCH) "+" {{REPO_NAME}}_TARGET_ISA;
 #undef XX
 #undef STRINGIFY
-}}
-)",
-        upper_name, ctx.repo_name);
+}
+)");
+    static const Template helloworld(R"(#include <iostream>
+#include "{{repo_name}}.h"
+int main(int argc, char** argv)
+{
+    std::cout << "hello {{repo_name}}! version:" << GetVersionString() << std::endl;
+}
+)");
+    // headers are always under the 'repo_name' dir
+    static const Template header(R"(#pragma once
+#define {{REPO_NAME}}_VERSION_MAJOR 0
+#define {{REPO_NAME}}_VERSION_MINOR 0
+#define {{REPO_NAME}}_VERSION_PATCH 1
+const char* GetVersionString();
+// if you want auto versioning feature, you can rename this file as {{repo_name}}.h.in
+// replace the version number to "@{{REPO_NAME}}_VERSION_MAJOR@" , etc.
+// then add `configure_file({{repo_name}}.h.in {{repo_name}}.h @ONLY)` in your CMakeLists.txt
+// CMake will replace the "@{{REPO_NAME}}_VERSION_MAJOR@" string with the actual version number
+// and generate the {{repo_name}}.h file in ${CMAKE_BINARY_DIR}
+)");
 
-    LOGINFO("{} written complete!", cppfile_name);
+    auto cppfile_name = fmt::format("{0}/{0}.cpp", ctx.repo_name);
+    EmitFile(ctx, cppfile_name, cppfile.Render(ctx), FileKind::STARTER);
+    if (ctx.verbose)
+        LOGINFO("{} written complete!", cppfile_name);
 
     if (RepoType::EXECUTABLE == ctx.repo_type)
     {
-        std::ofstream helloworld(fmt::format("{}/main.cpp", ctx.repo_name));
-        if (!helloworld)
+        EmitFile(ctx, fmt::format("{}/main.cpp", ctx.repo_name), helloworld.Render(ctx),
+            FileKind::STARTER);
+    }
+
+    auto header_name = fmt::format("{0}/{0}.h", ctx.repo_name);
+    EmitFile(ctx, header_name, header.Render(ctx), FileKind::STARTER);
+    if (ctx.verbose)
+        LOGINFO("{} written complete!", header_name);
+}
+
+// the source files under root_dir/dir, relative to root_dir and sorted, so the generated lists do
+// not depend on the order of the directory iteration
+static std::vector<std::string> ListSources(fs::path const &root_dir, std::string const &dir,
+    bool recursive)
+{
+    static const std::set<std::string> extensions = {".c", ".cc", ".cpp", ".cxx"};
+    std::vector<std::string> sources;
+    error_code ec;
+    fs::recursive_directory_iterator it(root_dir / dir, ec), end;
+    for (; !ec && it != end; it.increment(ec))
+    {
+        auto const &path = it->path();
+        if (fs::is_directory(path))
         {
-            LOGERR("failed to open file: {}/main.cpp", ctx.repo_name);
+            if (!recursive)
+            {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (extensions.count(path.extension().string()))
+        {
+            sources.push_back(path.lexically_relative(root_dir).generic_string());
         }
-        helloworld << fmt::format(R"(#include <iostream>
-#include "{0}.h"
-int main(int argc, char** argv)
-{{
-    std::cout << "hello {0}! version:" << GetVersionString() << std::endl;
-}}
-)",
-            ctx.repo_name);
     }
+    std::sort(sources.begin(), sources.end());
+    return sources;
+}
 
-    // headers are always under the 'repo_name' dir
-    auto header_name = fmt::format("{0}/{0}.h", ctx.repo_name);
-    std::ofstream header(header_name);
-    if (!header)
-    {
-        LOGERR("failed to open file: {}", header_name);
-    }
-    header << fmt::format(
-        R"(#pragma once
-#define {0}_VERSION_MAJOR 0
-#define {0}_VERSION_MINOR 0
-#define {0}_VERSION_PATCH 1
-const char* GetVersionString();)",
-        upper_name);
-    header << R"(
-// if you want auto versioning feature, you can rename this file as {0}.h.in
-// replace the version number to "@{0}_VERSION_MAJOR@" , etc.
-// then add `configure_file({0}.h.in {0}.h @ONLY)` in your CMakeLists.txt
-// CMake will replace the "@{0}_VERSION_MAJOR@" string with the actual version number
-// and generate the {0}.h file in ${CMAKE_BINARY_DIR}
-)";
+static void AppendSourceList(
+    std::string &out, std::string const &name, std::vector<std::string> const &sources)
+{
+    out += "set(" + name + "\n";
+    for (auto const &source : sources)
+    {
+        out += "    ${PROJECT_SOURCE_DIR}/" + source + "\n";
+    }
+    out += "    )\n";
+}
 
-    LOGINFO("{} written complete!", header_name);
+void WriteSources(WriterContext const &ctx)
+{
+    std::string sources = "# written by cmaker, run 'cmaker sync' after adding, removing or renaming "
+                          "a source file\n";
+    AppendSourceList(sources,
+        RepoType::EXECUTABLE == ctx.repo_type ? "EXECUTABLE_SRC" : "LIBRARY_SRC",
+        ListSources(ctx.root_dir, ctx.repo_name, true));
+    AppendSourceList(sources, "UNIT_TEST_SRCS", ListSources(ctx.root_dir, "unit_test", false));
+    AppendSourceList(sources, "BENCHMARK_SRCS", ListSources(ctx.root_dir, "bench", false));
+    EmitFile(ctx, "sources.cmake", sources);
 }
 
-void WriteGitignore()
+void WriteGitignore(WriterContext const &ctx)
 {
-    std::ofstream gitignore(".gitignore");
-    gitignore << R"(# compile outputs
+    EmitFile(ctx, ".gitignore", R"(# compile outputs
 *.o
 *.obj
 *.ko
@@ -324,6 +3184,7 @@ __pycache__/
 # build related
 autom4te.cache/
 build/
+CMakeUserPresets.json
 build64_debug/
 build64_release/
 blade-bin/
@@ -335,13 +3196,12 @@ bin/
 .cache/
 .DS_Store
 ehthumbs.db
-Thumbs.db)";
+Thumbs.db)");
 }
 
-void WriteClangformat()
+void WriteClangformat(WriterContext const &ctx)
 {
-    std::ofstream clangformat(".clang-format");
-    clangformat << R"(---
+    EmitFile(ctx, ".clang-format", R"(---
 Language:        Cpp
 # BasedOnStyle:  LLVM
 AccessModifierOffset: -4
@@ -449,7 +3309,7 @@ TabWidth:        8
 UseTab:          Never
 IndentPPDirectives: AfterHash
 ...
-)";
+)");
 }
 
 const std::string license_MIT = R"(MIT License
@@ -869,68 +3729,216 @@ DEALINGS IN THE SOFTWARE.
 
 void WriteLicense(WriterContext const &ctx)
 {
-    std::ofstream license("LICENSE");
-    if (ctx.license.empty())
-    {
-        license << license_MIT;
-    }
-    else if (ToUpper(ctx.license) == "MIT")
+    auto license = ToUpper(ctx.license);
+    if (license.empty() || license == "MIT")
     {
-        license << license_MIT;
+        EmitFile(ctx, "LICENSE", license_MIT, FileKind::STARTER);
     }
-    else if (ToUpper(ctx.license) == "LGPLV3")
+    else if (license == "LGPLV3")
     {
-        license << license_LGPLV3;
+        EmitFile(ctx, "LICENSE", license_LGPLV3, FileKind::STARTER);
     }
-    else if (ToUpper(ctx.license) == "APACHE")
+    else if (license == "APACHE")
     {
-        license << license_APACHE;
+        EmitFile(ctx, "LICENSE", license_APACHE, FileKind::STARTER);
     }
-    else if (ToUpper(ctx.license) == "BOOST")
+    else if (license == "BOOST")
     {
-        license << license_BOOST;
+        EmitFile(ctx, "LICENSE", license_BOOST, FileKind::STARTER);
     }
     else
     {
         LOGWARN("unsupported license type: {}, use MIT license instead", ctx.license);
-        license << license_MIT;
+        EmitFile(ctx, "LICENSE", license_MIT, FileKind::STARTER);
     }
 }
 
+void WriteCMakePresets(WriterContext const &ctx)
+{
+    // every preset builds into build/<preset>, so they can live side by side. The presets have no
+    // value for all the cores, the parallel one leaves the job count to ctest -j on the command line
+    EmitFile(ctx, "CMakePresets.json", R"({
+    "version": 3,
+    "cmakeMinimumRequired": {
+        "major": 3,
+        "minor": 21,
+        "patch": 0
+    },
+    "configurePresets": [
+        {
+            "name": "base",
+            "hidden": true,
+            "generator": "Ninja",
+            "binaryDir": "${sourceDir}/build/${presetName}",
+            "cacheVariables": {
+                "CMAKE_EXPORT_COMPILE_COMMANDS": "ON"
+            }
+        },
+        {
+            "name": "release",
+            "displayName": "Release",
+            "description": "optimized build with -O3 and assertions off",
+            "inherits": "base",
+            "cacheVariables": {
+                "CMAKE_BUILD_TYPE": "Release",
+                "CMAKE_C_FLAGS_RELEASE": "-O3 -DNDEBUG",
+                "CMAKE_CXX_FLAGS_RELEASE": "-O3 -DNDEBUG",
+                "BUILD_TESTS": "ON"
+            }
+        },
+        {
+            "name": "relwithdebinfo-perf",
+            "displayName": "RelWithDebInfo for profiling",
+            "description": "optimized build with debug info, frame pointers and no PIE, so perf unwinds and symbolizes every frame",
+            "inherits": "base",
+            "cacheVariables": {
+                "CMAKE_BUILD_TYPE": "RelWithDebInfo",
+                "CMAKE_C_FLAGS_RELWITHDEBINFO": "-O2 -g -DNDEBUG -fno-omit-frame-pointer -fno-pie",
+                "CMAKE_CXX_FLAGS_RELWITHDEBINFO": "-O2 -g -DNDEBUG -fno-omit-frame-pointer -fno-pie",
+                "CMAKE_EXE_LINKER_FLAGS": "-no-pie",
+                "BUILD_TESTS": "ON",
+                "BUILD_BENCHMARKS": "ON"
+            }
+        },
+        {
+            "name": "bench",
+            "displayName": "Benchmarks",
+            "description": "release build of the benchmarks, warns when CPU frequency scaling may skew the numbers",
+            "inherits": "release",
+            "cacheVariables": {
+                "BUILD_TESTS": "OFF",
+                "BUILD_BENCHMARKS": "ON",
+                "BENCH_CHECK_CPU_SCALING": "ON"
+            }
+        },
+        {
+            "name": "debug",
+            "displayName": "Debug",
+            "description": "unoptimized build with debug info and assertions on",
+            "inherits": "base",
+            "cacheVariables": {
+                "CMAKE_BUILD_TYPE": "Debug",
+                "BUILD_TESTS": "ON"
+            }
+        }
+    ],
+    "buildPresets": [
+        {
+            "name": "release",
+            "configurePreset": "release"
+        },
+        {
+            "name": "relwithdebinfo-perf",
+            "configurePreset": "relwithdebinfo-perf"
+        },
+        {
+            "name": "bench",
+            "configurePreset": "bench"
+        },
+        {
+            "name": "debug",
+            "configurePreset": "debug"
+        }
+    ],
+    "testPresets": [
+        {
+            "name": "base",
+            "hidden": true,
+            "output": {
+                "outputOnFailure": true
+            }
+        },
+        {
+            "name": "release",
+            "inherits": "base",
+            "configurePreset": "release"
+        },
+        {
+            "name": "relwithdebinfo-perf",
+            "inherits": "base",
+            "configurePreset": "relwithdebinfo-perf"
+        },
+        {
+            "name": "debug",
+            "inherits": "base",
+            "configurePreset": "debug"
+        },
+        {
+            "name": "bench",
+            "description": "instruction count checks of the benchmarks, configure with -DBENCH_INSTRUCTION_COUNT=ON",
+            "inherits": "base",
+            "configurePreset": "bench",
+            "filter": {
+                "include": {
+                    "label": "instruction_count"
+                }
+            }
+        },
+        {
+            "name": "parallel",
+            "description": "release tests for ctest -j, the slowest ones by the recorded CTestCostData.txt start first",
+            "inherits": "release"
+        }
+    ]
+}
+)");
+}
+
 void WriteReadme(WriterContext const &ctx)
 {
-    std::ofstream readme("README.md");
-    readme << fmt::format("# {}\n", ctx.repo_name);
-    if (RepoType::EXECUTABLE == ctx.repo_type)
-    {
-        readme << "## Build\n"
-               << "```bash\n"
-               << "mkdir build && cd build\n"
-               << "cmake ..\n"
-               << "make\n"
-               << "```\n";
-    }
-    else
-    {
-        readme << "## Build\n"
-               << "```bash\n"
-               << "mkdir build && cd build\n"
-               << "cmake .. -DBUILD_TESTS=ON -DBUILD_BENCHMARKS=ON\n"
-               << "make\n"
-               << "make test\n"
-               << "make bench\n"
-               << "```\n";
-    }
-    readme << "## License\n"
-           << fmt::format("This project is licensed under the {} License - see the "
-                          "[LICENSE](LICENSE) file for details.\n",
-                  ctx.license);
+    static const Template title(R"(# {{repo_name}}
+)");
+    static const Template build(R"(## Build
+The presets in CMakePresets.json build with Ninja into `build/<preset>`:
+
+| preset | purpose |
+|---|---|
+| `release` | `-O3 -DNDEBUG` with the unit tests |
+| `relwithdebinfo-perf` | debug info, frame pointers and no PIE for `perf record -g` |
+| `bench` | release build of the benchmarks, warns when CPU frequency scaling is on |
+| `debug` | unoptimized with assertions |
+
+```bash
+cmake --preset release
+cmake --build --preset release
+ctest --preset release
+# every gtest case is its own ctest entry, run them in parallel on all the cores
+ctest --preset parallel -j $(nproc)
+
+cmake --preset bench
+cmake --build --preset bench
+./build/bench/bench/bench_example
+# every benchmark of bench/, its JSON results are kept under build/bench-results/<benchmark>
+cmake --build --preset bench --target run-benchmarks
+# pinned to CPUs 2-3 with hardware counters, IPC and MPKI, Google Benchmark needs libpfm for them
+cmake --preset bench -DBENCH_CPU_SET=2-3 -DBENCH_PERF_COUNTERS=ON
+cmake --build --preset bench --target run-benchmarks
+# cachegrind counts checked against bench/baseline/<benchmark>.txt, immune to the timing noise
+cmake --preset bench -DBENCH_INSTRUCTION_COUNT=ON
+cmake --build --preset bench --target bench_example-instruction-count
+ctest --preset bench
+# allocs/iter and bytes/iter of the benchmarks using bench/support/alloc_counter.h
+cmake --preset bench -DBENCH_COUNT_ALLOCS=ON
+cmaker bench-history build/bench-results
+# the workloads of bench/allocator timed under every heap allocator installed, while the main
+# target, the unit tests and the benchmarks use the one of -DALLOCATOR=jemalloc, mimalloc or tcmalloc
+cmake --build --preset bench --target compare-allocators
+```
+)");
+    static const Template license(R"(## License
+This project is licensed under the {{license}} License - see the [LICENSE](LICENSE) file for details.
+)");
+
+    std::string readme;
+    title.RenderTo(readme, ctx);
+    build.RenderTo(readme, ctx);
+    license.RenderTo(readme, ctx);
+    EmitFile(ctx, "README.md", readme, FileKind::STARTER);
 }
 
-void WriteClangTidy()
+void WriteClangTidy(WriterContext const &ctx)
 {
-    std::ofstream clangtidy(".clang-tidy");
-    clangtidy << R"(Checks: 'cppcoreguidelines-*,
+    EmitFile(ctx, ".clang-tidy", R"(Checks: 'cppcoreguidelines-*,
 performance-*,
 modernize-*,
 google-*,
@@ -982,5 +3990,5 @@ CheckOptions:
     value:           llvm
   - key:             modernize-use-nullptr.NullMacros
     value:           'NULL'
-)";
+)");
 }
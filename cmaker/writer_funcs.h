@@ -1,6 +1,8 @@
 #pragma once
 #include "functions.h"
+#include "template.h"
 #include <fstream>
+#include <map>
 
 enum class RepoType
 {
@@ -9,20 +11,95 @@ enum class RepoType
     EXECUTABLE,
 };
 
+// files visited by 'cmaker regen', relative to the repo root
+struct RegenSummary
+{
+    std::vector<std::string> changed;
+    std::vector<std::string> unchanged;
+    // edited by hand since cmaker wrote them, left as they are unless overwrite_edited is set
+    std::vector<std::string> edited;
+    bool overwrite_edited{false};
+};
+
+// content hashes of the scaffold files written by one run, by path relative to the repo root
+struct GeneratedHashes
+{
+    std::map<std::string, std::uint64_t> written;
+};
+
+// SCAFFOLD files are owned by cmaker and kept up to date by 'cmaker regen'
+// STARTER files are handed over to the user once created and never regenerated
+enum class FileKind
+{
+    SCAFFOLD,
+    STARTER,
+};
+
 struct WriterContext
 {
+    // set both repo_name and upper_name
+    void SetRepoName(std::string name)
+    {
+        repo_name = std::move(name);
+        upper_name = ToUpper(repo_name);
+    }
+
     std::string repo_name;
-    RepoType repo_type;
+    // upper cased repo_name, computed once for all the templates
+    std::string upper_name;
+    RepoType repo_type{RepoType::STATIC};
     std::string cxx_std{"11"};
     std::string license;
+    // sources merged into one unity batch, 0 disables unity build
+    unsigned unity_batch_size{0};
+    // precompile the common headers of the main target, unit tests and benchmarks
+    bool pch{false};
+    // link-time optimization: off, full or thin
+    std::string lto_mode{"off"};
+    // default linker: auto, mold, lld, gold or default, which leaves the compiler's choice
+    std::string linker{"auto"};
+    // default heap allocator: system, jemalloc, mimalloc or tcmalloc
+    std::string allocator{"system"};
+    // instruction set of the builds: baseline, x86-64-v2, x86-64-v3, x86-64-v4 or native
+    std::string target_isa{"baseline"};
+    // directory the repo is generated into, all the writers resolve their files against it
+    fs::path root_dir{"."};
+    // batch generation turns it off to keep one log line per project
+    bool verbose{true};
+    // set by 'cmaker regen', only the scaffold files whose content changed are written
+    RegenSummary *regen{nullptr};
+    // collects the hashes of the written scaffold files for SaveGeneratedHashes, nullptr keeps
+    // no record of them
+    GeneratedHashes *generated{nullptr};
 };
 
+// generate the whole repo under ctx.root_dir, which must not exist yet
+void WriteProject(WriterContext const& ctx);
+
+// read the settings of an existing repo back from its root CMakeLists.txt, false if it is not
+// a repo generated by cmaker
+bool LoadWriterContext(fs::path const& root, WriterContext& ctx);
+
+// write a rendered file under ctx.root_dir, abort on failure
+void EmitFile(WriterContext const& ctx, std::string const& relpath, std::string const& content,
+    FileKind kind = FileKind::SCAFFOLD);
+// merge the hashes collected in ctx.generated into .cmaker-generated, once all the files of the
+// run are written
+void SaveGeneratedHashes(WriterContext const& ctx);
+
 void WriteCMakeLists(WriterContext const& ctx);
-void WriteUnitTests();
-void WriteBenchmark();
+void WriteUnitTests(WriterContext const& ctx);
+void WriteBenchmark(WriterContext const& ctx);
+// the memory hierarchy and core-to-core calibration of 'cmaker template machine-bench'
+void WriteMachineBench(WriterContext const& ctx);
+// the runtime dispatched kernels of 'cmaker template simd', with their unit test and benchmark
+void WriteSimdKernels(WriterContext const& ctx);
 void WriteSrcAndHeader(WriterContext const& ctx);
-void WriteGitignore();
-void WriteClangformat();
+// list the library or executable sources, the unit tests and the benchmarks found under ctx.root_dir
+void WriteSources(WriterContext const& ctx);
+void WriteGitignore(WriterContext const& ctx);
+void WriteClangformat(WriterContext const& ctx);
 void WriteLicense(WriterContext const& ctx);
+void WriteCMakePresets(WriterContext const& ctx);
 void WriteReadme(WriterContext const& ctx);
-void WriteClangTidy();
+void WriteClangTidy(WriterContext const& ctx);
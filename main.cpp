@@ -1,32 +1,26 @@
 #include "functions.h"
 
-po::options_description all(fmt::format(
-    GREEN("\"CMaker\"") " ({}) is A CMakeLists.txt generater helper.\n"
-                        "The program will help you create a repo based on CMake build system "
-                        "with ease.\n"
-                        "You don't have to remember all those obscure syntax and commands.\n"
-                        "Start coding in just one command. All the common features of CMake "
-                        "will be added in\n"
-                        "the well-elaborated CMakeLists.txt template, along with GTest and "
-                        "benchmark examples.\n"
-                        "Here are the allowed options",
-    GetVersionString()));
-po::options_description general(BLUE("general options"));
-po::options_description creator(BLUE("create a new repo"));
-po::options_description adder_library(BLUE("add thirdparty library"));
-po::options_description adder_module(BLUE("add submodule"));
-po::options_description adder_template(BLUE("add benchmark or gtest template"));
-po::positional_options_description pos_desc;
-po::variables_map vm;
+extern po::options_description all;
+extern po::options_description general;
+extern po::options_description creator;
+extern po::options_description adder_library;
+extern po::options_description adder_module;
+extern po::options_description pch_tools;
+extern po::options_description watcher;
+extern po::options_description bench_tools;
+extern po::positional_options_description pos_desc;
+extern po::variables_map vm;
 
 int main(int argc, const char *argv[])
 {
     // clang-format off
     general.add_options()("help", "print the help message")
         ("operation", po::value<std::string>()->required(), 
-            "1st positional argument. supported operations: new, add-library, add-submodule, template")
+            "1st positional argument. supported operations: new, regen, sync, watch, add-library, add-submodule, template, pch, bench-diff, bench-history")
         ("name", po::value<std::string>()->required(), 
             "2nd positional argument. operand for the operation")
+        ("operand", po::value<std::string>(),
+            "3rd positional argument. second operand, such as new.json of 'cmaker bench-diff base.json new.json'")
         ("version,v", "print the version string")
         ("std", po::value<std::string>()->default_value("11"),
             "c++ standard version, default value is: 11")
@@ -37,6 +31,23 @@ int main(int argc, const char *argv[])
     creator.add_options()("static", "create a repo template based on library project (static library) [default]")
         ("shared", "create a repo template based on library project (shared library)")
         ("exe", "create a repo template based on executable project")
+        ("unity", po::value<unsigned>()->implicit_value(8),
+            "build the main target in unity batches of N sources (--unity=N), default batch size is 8, 0 turns it off")
+        ("pch", "precompile the common headers of the main target, unit tests and benchmarks")
+        ("lto", po::value<std::string>()->default_value("off"),
+            "link-time optimization of the release builds, supported values: off, full, thin, default value is: off")
+        ("linker", po::value<std::string>()->default_value("auto"),
+            "linker of the generated repo, supported values: auto, mold, lld, gold, default, default value is: auto")
+        ("allocator", po::value<std::string>()->default_value("system"),
+            "heap allocator of the generated repo, supported values: system, jemalloc, mimalloc, tcmalloc, default value is: system")
+        ("target-isa", po::value<std::string>()->default_value("auto"),
+            "instruction set of the generated repo, supported values: auto, baseline, x86-64-v2, x86-64-v3, x86-64-v4, native, "
+            "auto picks the highest of x86-64-v2 and x86-64-v3 which the compiler and this host support, default value is: auto")
+        ("force", "let 'cmaker regen' overwrite the generated files edited by hand since, which it keeps by default")
+        ("manifest", po::value<std::string>(),
+            "create every repo listed in the file, one per line: path/to/name [static|shared|exe] [std] [license]")
+        ("jobs,j", po::value<unsigned>()->default_value(0),
+            "number of threads creating repos from --manifest, default value 0 means one per CPU core")
         ;
     adder_library.add_options()
         ("path,L", po::value<std::string>(), "path to find the library, such as: thirdparty/mydep/lib")
@@ -46,10 +57,24 @@ int main(int argc, const char *argv[])
         ("url,U", po::value<std::string>(), "url to submodule, such as: https://github.com/me/myrepo.git")
         ("dir,D", po::value<std::string>()->default_value("thirdparty"), "directory where the submodule shall be initialized, default value is: thirdparty")
         ;
+    pch_tools.add_options()
+        ("top", po::value<size_t>()->default_value(10), "number of headers listed by 'cmaker pch suggest', default value is: 10")
+        ;
+    watcher.add_options()
+        ("build-dir,B", po::value<std::string>()->default_value("build"), "build directory rebuilt by 'cmaker watch', default value is: build")
+        ("debounce", po::value<unsigned>()->default_value(150), "milliseconds without any change before 'cmaker watch' starts a build, default value is: 150")
+        ;
+    bench_tools.add_options()
+        ("threshold", po::value<double>()->default_value(5.0), "percentage a benchmark may slow down before 'cmaker bench-diff' fails, default value is: 5")
+        ("alpha", po::value<double>()->default_value(0.05), "significance level of the Mann-Whitney U test of 'cmaker bench-diff', default value is: 0.05")
+        ("metric", po::value<std::string>()->default_value("real_time"), "time compared by 'cmaker bench-diff' and 'cmaker bench-history', supported values: real_time, cpu_time, default value is: real_time")
+        ("format", po::value<std::string>()->default_value("text"), "report of 'cmaker bench-history', supported values: text, html, default value is: text")
+        ("output", po::value<std::string>(), "html file written by 'cmaker bench-history --format=html', default value is: <results dir>/history.html")
+        ;
     // clang-format on
-    pos_desc.add("operation", 1).add("name", 1);
+    pos_desc.add("operation", 1).add("name", 1).add("operand", 1);
 
-    all.add(general).add(creator).add(adder_library).add(adder_module);
+    all.add(general).add(creator).add(adder_library).add(adder_module).add(pch_tools).add(watcher).add(bench_tools);
 
     if (!IsExecutableInPath("git"))
     {
@@ -87,6 +112,18 @@ int main(int argc, const char *argv[])
         {
             CreateNewProject();
         }
+        else if (op == "regen")
+        {
+            RegenProject();
+        }
+        else if (op == "sync")
+        {
+            SyncProject();
+        }
+        else if (op == "watch")
+        {
+            WatchProject();
+        }
         else if (op == "add-library")
         {
             AddThirdpartyLibrary();
@@ -99,6 +136,18 @@ int main(int argc, const char *argv[])
         {
             AddTemplate();
         }
+        else if (op == "pch")
+        {
+            ManagePch();
+        }
+        else if (op == "bench-diff")
+        {
+            BenchDiff();
+        }
+        else if (op == "bench-history")
+        {
+            BenchHistoryReport();
+        }
         else
         {
             LOGWARN("invalid operation: {}\n", op);
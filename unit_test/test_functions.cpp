@@ -1,5 +1,8 @@
+#include "bench_results.h"
 #include "functions.h"
+#include "writer_funcs.h"
 #include <gtest/gtest.h>
+#include <chrono>
 
 TEST(FUNCTIONS, TestPascalization)
 {
@@ -12,6 +15,139 @@ TEST(FUNCTIONS, TestPascalization)
     EXPECT_EQ(Pascalization("c--"), "C");
 }
 
+TEST(FUNCTIONS, TestParseSystemInclude)
+{
+    std::string header;
+    EXPECT_TRUE(ParseSystemInclude("#include <vector>", header));
+    EXPECT_EQ(header, "vector");
+    EXPECT_TRUE(ParseSystemInclude("  #  include\t<boost/asio.hpp> // net", header));
+    EXPECT_EQ(header, "boost/asio.hpp");
+    EXPECT_FALSE(ParseSystemInclude("#include \"functions.h\"", header));
+    EXPECT_FALSE(ParseSystemInclude("// #include <map>", header));
+    EXPECT_FALSE(ParseSystemInclude("#include <>", header));
+    EXPECT_FALSE(ParseSystemInclude("#pragma once", header));
+}
+
+TEST(TEMPLATE, TestRender)
+{
+    WriterContext ctx;
+    ctx.SetRepoName("my_lib");
+    ctx.cxx_std = "17";
+    EXPECT_EQ(Template("{{repo_name}}").Render(ctx), "my_lib");
+    EXPECT_EQ(Template("set(CMAKE_CXX_STANDARD {{cxx_std}})\n").Render(ctx),
+        "set(CMAKE_CXX_STANDARD 17)\n");
+    EXPECT_EQ(Template("${{{REPO_NAME}}_VERSION_MAJOR}").Render(ctx), "${MY_LIB_VERSION_MAJOR}");
+    EXPECT_EQ(Template("add_library(x {{library_type}})").Render(ctx), "add_library(x STATIC)");
+    EXPECT_EQ(Template("no variables {}").Render(ctx), "no variables {}");
+}
+
+TEST(TEMPLATE, TestContentHash)
+{
+    // reference values of 64-bit FNV-1a
+    EXPECT_EQ(ContentHash(""), 14695981039346656037ull);
+    EXPECT_EQ(ContentHash("a"), 12638187200555641996ull);
+    EXPECT_NE(ContentHash("CMakeLists.txt"), ContentHash("CMakeLists.txT"));
+}
+
+TEST(TEMPLATE, TestRegenKeepsEditedFile)
+{
+    WriterContext ctx;
+    ctx.root_dir = fs::temp_directory_path() / "cmaker_test_regen";
+    fs::remove_all(ctx.root_dir);
+    GeneratedHashes generated;
+    ctx.generated = &generated;
+    EmitFile(ctx, "CMakeLists.txt", "generated\n");
+    EmitFile(ctx, "sources.cmake", "generated\n");
+    EXPECT_FALSE(fs::exists(ctx.root_dir / ".cmaker-generated"));
+    SaveGeneratedHashes(ctx);
+    std::ofstream((ctx.root_dir / "CMakeLists.txt").string(), std::ios::app)
+        << "find_package(ZLIB)\n";
+
+    RegenSummary summary;
+    ctx.regen = &summary;
+    EmitFile(ctx, "CMakeLists.txt", "regenerated\n");
+    EmitFile(ctx, "sources.cmake", "regenerated\n");
+    EXPECT_EQ(summary.edited, std::vector<std::string>({"CMakeLists.txt"}));
+    EXPECT_EQ(summary.changed, std::vector<std::string>({"sources.cmake"}));
+    EXPECT_FALSE(IsFileContentSame(ctx.root_dir / "CMakeLists.txt", "regenerated\n"));
+
+    summary.overwrite_edited = true;
+    EmitFile(ctx, "CMakeLists.txt", "regenerated\n");
+    EXPECT_TRUE(IsFileContentSame(ctx.root_dir / "CMakeLists.txt", "regenerated\n"));
+    fs::remove_all(ctx.root_dir);
+}
+
+TEST(BENCH, TestMannWhitneyU)
+{
+    std::vector<double> base = {100, 101, 99, 102, 100, 98, 101, 100, 99, 101};
+    std::vector<double> same = {101, 99, 100, 100, 102, 98, 100, 101, 99, 100};
+    std::vector<double> slower = {110, 111, 109, 112, 110, 108, 111, 110, 109, 111};
+    EXPECT_GT(MannWhitneyU(base, same), 0.5);
+    EXPECT_LT(MannWhitneyU(base, slower), 0.001);
+    EXPECT_DOUBLE_EQ(MannWhitneyU(base, {}), 1);
+    EXPECT_DOUBLE_EQ(MannWhitneyU({5, 5}, {5, 5}), 1);
+
+    // 3 against 3 repetitions of a clear regression, the normal approximation gave 0.08, the
+    // exact test its floor of 2 / C(6, 3), which still can't pass 0.05, so bench-diff falls back
+    // to the threshold
+    std::vector<double> base3 = {100, 101, 99}, slower3 = {130, 131, 129};
+    EXPECT_DOUBLE_EQ(MannWhitneyU(base3, slower3), 0.1);
+    EXPECT_DOUBLE_EQ(MannWhitneyMinPValue(3, 3), 0.1);
+    EXPECT_DOUBLE_EQ(MannWhitneyU({100, 101, 99, 100.5}, {130, 131, 129, 130.5}), 2.0 / 70);
+    EXPECT_LT(MannWhitneyMinPValue(4, 4), 0.05);
+    EXPECT_DOUBLE_EQ(MannWhitneyU({1, 2, 2}, {2, 3, 4}), MannWhitneyU({2, 3, 4}, {1, 2, 2}));
+    EXPECT_DOUBLE_EQ(MannWhitneyU({1, 2, 2, 5, 6}, {2, 3}), MannWhitneyU({2, 3}, {1, 2, 2, 5, 6}));
+
+    // one side run with --benchmark_repetitions, the other once or twice, both orders
+    std::vector<double> many(300);
+    for (size_t i = 0; i < many.size(); ++i)
+    {
+        many[i] = 100 + static_cast<double>(i % 7);
+    }
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_GT(MannWhitneyU(many, {102, 103}), 0.5);
+    EXPECT_LT(MannWhitneyU({150, 151}, many), 0.05);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+    auto shift = HodgesLehmann(base, slower, 0.95);
+    EXPECT_DOUBLE_EQ(shift.shift, 10);
+    EXPECT_LE(shift.low, 10);
+    EXPECT_GE(shift.high, 10);
+    EXPECT_GT(shift.low, 0);
+    EXPECT_DOUBLE_EQ(Median({3, 1, 2}), 2);
+    EXPECT_DOUBLE_EQ(Median({4, 1, 2, 3}), 2.5);
+}
+
+TEST(BENCH, TestLoadBenchResults)
+{
+    auto path = fs::temp_directory_path() / "cmaker_test_bench.json";
+    std::ofstream(path.string()) << R"({
+  "context": {"host_name": "box", "num_cpus": 8},
+  "benchmarks": [
+    {"name": "BM_a/8", "run_name": "BM_a/8", "run_type": "iteration", "real_time": 1.5,
+     "cpu_time": 1.25, "time_unit": "us"},
+    {"name": "BM_a/8", "run_name": "BM_a/8", "run_type": "iteration", "real_time": 2,
+     "cpu_time": 1.75, "time_unit": "us"},
+    {"name": "BM_a/8_mean", "run_name": "BM_a/8", "run_type": "aggregate", "real_time": 1.75,
+     "cpu_time": 1.5, "time_unit": "us"},
+    {"name": "BM_b", "real_time": 30, "cpu_time": 29, "time_unit": "ns"}
+  ]
+})";
+    BenchResults results;
+    std::string error;
+    ASSERT_TRUE(LoadBenchResults(path, results, error)) << error;
+    fs::remove(path);
+
+    EXPECT_EQ(results.context["host_name"], "box");
+    ASSERT_EQ(results.runs.size(), 2u);
+    EXPECT_EQ(results.runs[0].name, "BM_a/8");
+    EXPECT_EQ(results.runs[0].real_time, std::vector<double>({1500, 2000}));
+    EXPECT_EQ(results.runs[0].cpu_time, std::vector<double>({1250, 1750}));
+    ASSERT_NE(results.Find("BM_b"), nullptr);
+    EXPECT_EQ(results.Find("BM_b")->real_time, std::vector<double>({30}));
+    EXPECT_EQ(results.Find("BM_c"), nullptr);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);